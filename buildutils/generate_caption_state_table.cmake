@@ -0,0 +1,141 @@
+# Generates a constexpr table of caption button icon paths indexed by the
+# packed caption state (see CSD::Internal::captionStateIndex).
+#
+# Usage:
+#   cmake -DQRC_FILE=<csd.qrc> -DSOURCE_DIR=<dir> -DOUTPUT_FILE=<header>
+#         -P generate_caption_state_table.cmake
+#
+# Fails if any style/state combination maps to an asset that is missing from
+# the resource file or from the source tree.
+
+cmake_minimum_required(VERSION 3.15)
+
+foreach (required_var QRC_FILE SOURCE_DIR OUTPUT_FILE)
+    if ("${${required_var}}" STREQUAL "")
+        message(FATAL_ERROR "${required_var} is not set")
+    endif ()
+endforeach ()
+
+file(STRINGS "${QRC_FILE}" qrc_lines REGEX "<file>.*</file>")
+set(qrc_files "")
+foreach (qrc_line ${qrc_lines})
+    string(REGEX REPLACE ".*<file>(.*)</file>.*" "\\1" qrc_file "${qrc_line}")
+    list(APPEND qrc_files "${qrc_file}")
+endforeach ()
+
+# Mirrors the caption button artwork rules of each CaptionButtonStyle.
+function(caption_state_assets style active maximized hovered pressed out_var)
+    if (style STREQUAL "custom" OR style STREQUAL "win")
+        # Alpha masks, the state only picks the tint at runtime
+        set(dir "resources/titlebar/${style}")
+        if (maximized)
+            set(max_name "chrome-restore")
+        else ()
+            set(max_name "chrome-maximize")
+        endif ()
+        set(assets
+            "${dir}/chrome-minimize.svg"
+            "${dir}/${max_name}.svg"
+            "${dir}/chrome-close.svg")
+    elseif (style STREQUAL "mac")
+        set(dir "resources/titlebar/mac")
+        if (maximized)
+            set(max_state "maximized")
+        else ()
+            set(max_state "normal")
+        endif ()
+        if (pressed)
+            set(assets
+                "${dir}/minimize-pressed.png"
+                "${dir}/maximize-restore-${max_state}-pressed.png"
+                "${dir}/close-pressed.png")
+        elseif (hovered)
+            set(assets
+                "${dir}/minimize-hovered.png"
+                "${dir}/maximize-restore-${max_state}-hovered.png"
+                "${dir}/close-hovered.png")
+        elseif (active)
+            set(assets
+                "${dir}/minimize.png"
+                "${dir}/maximize-restore.png"
+                "${dir}/close.png")
+        else ()
+            set(assets
+                "${dir}/inactive.png"
+                "${dir}/inactive.png"
+                "${dir}/inactive.png")
+        endif ()
+    else ()
+        message(FATAL_ERROR "Unknown caption button style '${style}'")
+    endif ()
+    set(${out_var} "${assets}" PARENT_SCOPE)
+endfunction()
+
+# Order must match CSD::CaptionButtonStyle
+set(styles custom win mac)
+set(bool_values 0 1)
+
+set(table_entries "")
+set(state_count 0)
+foreach (style ${styles})
+    foreach (active ${bool_values})
+        foreach (maximized ${bool_values})
+            foreach (hovered ${bool_values})
+                foreach (pressed ${bool_values})
+                    caption_state_assets(
+                        ${style} ${active} ${maximized} ${hovered} ${pressed}
+                        assets)
+                    set(row "")
+                    foreach (asset ${assets})
+                        if (NOT asset IN_LIST qrc_files)
+                            message(FATAL_ERROR
+                                "${style} active=${active} "
+                                "maximized=${maximized} hovered=${hovered} "
+                                "pressed=${pressed}: '${asset}' is not "
+                                "listed in ${QRC_FILE}")
+                        endif ()
+                        if (NOT EXISTS "${SOURCE_DIR}/${asset}")
+                            message(FATAL_ERROR
+                                "${style} active=${active} "
+                                "maximized=${maximized} hovered=${hovered} "
+                                "pressed=${pressed}: '${SOURCE_DIR}/${asset}' "
+                                "does not exist")
+                        endif ()
+                        set(path ":/${asset}")
+                        string(LENGTH "${path}" path_length)
+                        string(APPEND row
+                            "            QStringView(u\"${path}\", ${path_length}),\n")
+                    endforeach ()
+                    string(APPEND table_entries
+                        "        // ${style} active=${active} "
+                        "maximized=${maximized} hovered=${hovered} "
+                        "pressed=${pressed}\n"
+                        "        std::array<QStringView, 3>{\n${row}        },\n")
+                    math(EXPR state_count "${state_count} + 1")
+                endforeach ()
+            endforeach ()
+        endforeach ()
+    endforeach ()
+endforeach ()
+
+set(content "// Generated by generate_caption_state_table.cmake from csd.qrc.
+// Do not edit.
+#pragma once
+
+#include <QStringView>
+
+#include <array>
+#include <cstddef>
+
+namespace CSD::Internal {
+
+constexpr std::size_t captionStateCount = ${state_count};
+
+constexpr std::array<std::array<QStringView, 3>, captionStateCount>
+    captionStateTable = {
+${table_entries}};
+
+} // namespace CSD::Internal
+")
+
+file(WRITE "${OUTPUT_FILE}" "${content}")
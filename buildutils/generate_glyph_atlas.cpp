@@ -0,0 +1,230 @@
+// Pre-rasterizes every caption glyph of csd.qrc at a set of scale factors and
+// packs them into one atlas. The pixels and the rect index are written as a
+// header so the atlas ends up uncompressed in the read-only data of the
+// binary and can be wrapped by a QImage without decoding anything.
+//
+// Usage:
+//   generate_glyph_atlas <output header> <icon size> <scale percent>...
+
+#include "csdcaptionstatetable.h"
+#include "csdglyphraster.h"
+
+#include <QFile>
+#include <QGuiApplication>
+#include <QImage>
+#include <QPainter>
+#include <QRect>
+#include <QString>
+#include <QTextStream>
+
+#include <algorithm>
+#include <cstdio>
+#include <map>
+#include <utility>
+#include <vector>
+
+namespace {
+
+constexpr int atlasMinimumWidth = 256;
+constexpr int glyphPadding = 1;
+
+struct Glyph {
+    QImage image;
+    QRect rect;
+};
+
+// Shelf packing, tallest glyphs first
+int packGlyphs(std::vector<Glyph> &glyphs, int atlasWidth) {
+    auto order = std::vector<std::size_t>(glyphs.size());
+    for (std::size_t i = 0; i < order.size(); ++i) {
+        order[i] = i;
+    }
+    std::stable_sort(std::begin(order),
+                     std::end(order),
+                     [&glyphs](std::size_t a, std::size_t b) {
+                         return glyphs[a].image.height() >
+                                glyphs[b].image.height();
+                     });
+
+    int x = 0;
+    int y = 0;
+    int shelfHeight = 0;
+    for (std::size_t index : order) {
+        auto &glyph = glyphs[index];
+        if (glyph.image.isNull()) {
+            continue;
+        }
+        const int width = glyph.image.width() + glyphPadding;
+        const int height = glyph.image.height() + glyphPadding;
+        if (x + width > atlasWidth) {
+            x = 0;
+            y += shelfHeight;
+            shelfHeight = 0;
+        }
+        glyph.rect = QRect(x, y, glyph.image.width(), glyph.image.height());
+        x += width;
+        shelfHeight = std::max(shelfHeight, height);
+    }
+    return y + shelfHeight;
+}
+
+} // namespace
+
+int main(int argc, char *argv[]) {
+    // Only needs to decode images, never to show anything
+    if (qEnvironmentVariableIsEmpty("QT_QPA_PLATFORM")) {
+        qputenv("QT_QPA_PLATFORM", "offscreen");
+    }
+    QGuiApplication application(argc, argv);
+
+    const auto arguments = QGuiApplication::arguments();
+    if (arguments.size() < 4) {
+        std::fprintf(stderr,
+                     "usage: generate_glyph_atlas <output header> "
+                     "<icon size> <scale percent>...\n");
+        return 1;
+    }
+    const auto outputPath = arguments[1];
+    const int iconSize = arguments[2].toInt();
+    auto scalePercents = std::vector<int>();
+    for (int i = 3; i < arguments.size(); ++i) {
+        const int percent = arguments[i].toInt();
+        if (percent <= 0) {
+            std::fprintf(stderr,
+                         "invalid scale percent '%s'\n",
+                         qPrintable(arguments[i]));
+            return 1;
+        }
+        scalePercents.push_back(percent);
+    }
+    if (iconSize <= 0) {
+        std::fprintf(
+            stderr, "invalid icon size '%s'\n", qPrintable(arguments[2]));
+        return 1;
+    }
+
+    // Assets are shared between many caption states, decode each once
+    auto glyphs = std::vector<Glyph>();
+    auto glyphIndices =
+        std::map<std::pair<QString, std::size_t>, std::size_t>();
+    auto stateGlyphs = std::vector<std::vector<std::size_t>>(
+        scalePercents.size(),
+        std::vector<std::size_t>(CSD::Internal::captionStateCount * 3));
+    int widestGlyph = 0;
+    for (std::size_t scale = 0; scale < scalePercents.size(); ++scale) {
+        const qreal devicePixelRatio = scalePercents[scale] / 100.0;
+        for (std::size_t state = 0; state < CSD::Internal::captionStateCount;
+             ++state) {
+            for (std::size_t button = 0; button < 3; ++button) {
+                const auto path =
+                    CSD::Internal::captionStateTable[state][button].toString();
+                const auto key = std::make_pair(path, scale);
+                auto it = glyphIndices.find(key);
+                if (it == std::end(glyphIndices)) {
+                    auto image = CSD::Internal::rasterizeGlyphImage(
+                        path, devicePixelRatio, QSize(iconSize, iconSize));
+                    if (image.isNull()) {
+                        std::fprintf(stderr,
+                                     "warning: cannot decode '%s', it will "
+                                     "be loaded at runtime\n",
+                                     qPrintable(path));
+                    } else {
+                        image = image.convertToFormat(
+                            QImage::Format_ARGB32_Premultiplied);
+                        image.setDevicePixelRatio(1.0);
+                        widestGlyph = std::max(widestGlyph, image.width());
+                    }
+                    it = glyphIndices.emplace(key, glyphs.size()).first;
+                    glyphs.push_back(Glyph{std::move(image), QRect()});
+                }
+                stateGlyphs[scale][state * 3 + button] = it->second;
+            }
+        }
+    }
+
+    const int atlasWidth =
+        std::max(atlasMinimumWidth, widestGlyph + glyphPadding);
+    const int atlasHeight = std::max(1, packGlyphs(glyphs, atlasWidth));
+    auto atlas = QImage(
+        atlasWidth, atlasHeight, QImage::Format_ARGB32_Premultiplied);
+    atlas.fill(Qt::transparent);
+    {
+        auto painter = QPainter(&atlas);
+        painter.setCompositionMode(QPainter::CompositionMode_Source);
+        for (const auto &glyph : glyphs) {
+            if (!glyph.image.isNull()) {
+                painter.drawImage(glyph.rect.topLeft(), glyph.image);
+            }
+        }
+    }
+
+    auto output = QFile(outputPath);
+    if (!output.open(QIODevice::WriteOnly | QIODevice::Truncate |
+                     QIODevice::Text)) {
+        std::fprintf(stderr, "cannot write '%s'\n", qPrintable(outputPath));
+        return 1;
+    }
+    auto stream = QTextStream(&output);
+    stream << "// Generated by generate_glyph_atlas from csd.qrc.\n"
+              "// Do not edit.\n"
+              "#pragma once\n\n"
+              "#include \"csdcaptionstatetable.h\"\n\n"
+              "#include <QtGlobal>\n\n"
+              "#include <array>\n"
+              "#include <cstddef>\n\n"
+              "namespace CSD::Internal {\n\n";
+    stream << "constexpr int glyphAtlasIconSize = " << iconSize << ";\n";
+    stream << "constexpr std::size_t glyphAtlasScaleCount = "
+           << scalePercents.size() << ";\n";
+    stream << "constexpr std::array<int, glyphAtlasScaleCount>\n"
+              "    glyphAtlasScalePercents = {";
+    for (std::size_t i = 0; i < scalePercents.size(); ++i) {
+        stream << (i == 0 ? "" : ", ") << scalePercents[i];
+    }
+    stream << "};\n";
+    stream << "constexpr int glyphAtlasWidth = " << atlasWidth << ";\n";
+    stream << "constexpr int glyphAtlasHeight = " << atlasHeight << ";\n\n";
+
+    stream << "// x, y, width and height of each glyph, indexed by scale\n"
+              "// and captionStateIndex() * 3 + button. Empty if the asset\n"
+              "// could not be decoded at build time.\n"
+              "constexpr std::array<\n"
+              "    std::array<std::array<quint16, 4>,\n"
+              "               captionStateCount * 3>,\n"
+              "    glyphAtlasScaleCount>\n"
+              "    glyphAtlasRects = {{\n";
+    for (std::size_t scale = 0; scale < scalePercents.size(); ++scale) {
+        stream << "        {{\n";
+        for (std::size_t glyphIndex : stateGlyphs[scale]) {
+            const auto &rect = glyphs[glyphIndex].rect;
+            stream << "            {{" << rect.x() << ", " << rect.y() << ", "
+                   << rect.width() << ", " << rect.height() << "}},\n";
+        }
+        stream << "        }},\n";
+    }
+    stream << "    }};\n\n";
+
+    stream << "// Premultiplied ARGB32, one row after the other\n"
+              "alignas(16) static const std::array<quint32,\n"
+              "                                    static_cast<std::size_t>(\n"
+              "                                        glyphAtlasWidth *\n"
+              "                                        glyphAtlasHeight)>\n"
+              "    glyphAtlasPixels = {{\n";
+    stream.setIntegerBase(16);
+    stream.setNumberFlags(QTextStream::ShowBase);
+    for (int y = 0; y < atlasHeight; ++y) {
+        const auto *line =
+            reinterpret_cast<const QRgb *>(atlas.constScanLine(y));
+        for (int x = 0; x < atlasWidth; x += 8) {
+            stream << "        ";
+            for (int i = x; i < std::min(x + 8, atlasWidth); ++i) {
+                stream << line[i] << "u,";
+                stream << (i + 1 < std::min(x + 8, atlasWidth) ? " " : "");
+            }
+            stream << "\n";
+        }
+    }
+    stream << "    }};\n\n"
+              "} // namespace CSD::Internal\n";
+    return stream.status() == QTextStream::Ok ? 0 : 1;
+}
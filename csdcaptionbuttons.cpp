@@ -0,0 +1,111 @@
+#include "csdcaptionbuttons.h"
+
+#include <QStyle>
+
+#include <algorithm>
+
+namespace CSD::Internal {
+
+CaptionLayout layoutCaption(const QSize &size,
+                            const StyleMetrics &metrics,
+                            int leftMargin,
+                            bool minimizable,
+                            bool maximizable,
+                            Qt::LayoutDirection direction) {
+    const int spacing = metrics.horizontalSpacing;
+    const int buttonSize = metrics.buttonSize;
+    const auto partRect = [&size](int x, int width, int height) {
+        return QRect(x, (size.height() - height) / 2, width, height);
+    };
+
+    auto layout = CaptionLayout();
+    auto &parts = layout.parts;
+    int left = leftMargin > 0 ? leftMargin + spacing : 0;
+    parts[TitleBarButton::CaptionIcon] =
+        partRect(left, buttonSize, buttonSize);
+    left += buttonSize + spacing;
+
+    int right = size.width() - buttonSize;
+    parts[TitleBarButton::Close] =
+        partRect(right, buttonSize, metrics.buttonIconSize);
+    if (maximizable) {
+        right -= buttonSize + spacing;
+        parts[TitleBarButton::MaximizeRestore] =
+            partRect(right, buttonSize, buttonSize);
+    }
+    if (minimizable) {
+        right -= buttonSize + spacing;
+        parts[TitleBarButton::Minimize] =
+            partRect(right, buttonSize, buttonSize);
+    }
+    layout.freeArea =
+        QRect(left, 0, std::max(0, right - spacing - left), size.height());
+
+    const auto bounds = QRect(QPoint(0, 0), size);
+    for (auto &rect : parts) {
+        if (!rect.isNull()) {
+            rect = QStyle::visualRect(direction, bounds, rect);
+        }
+    }
+    layout.freeArea = QStyle::visualRect(direction, bounds, layout.freeArea);
+    return layout;
+}
+
+int CaptionButtonStates::hovered() const {
+    return this->m_hovered;
+}
+
+int CaptionButtonStates::pressed() const {
+    return this->m_pressed;
+}
+
+int CaptionButtonStates::buttonAt(const CaptionLayout &layout,
+                                  const QPoint &pos) {
+    for (const auto role : {TitleBarButton::Minimize,
+                            TitleBarButton::MaximizeRestore,
+                            TitleBarButton::Close}) {
+        if (layout.parts[role].contains(pos)) {
+            return role;
+        }
+    }
+    return none;
+}
+
+bool CaptionButtonStates::setHovered(int role) {
+    if (role == this->m_hovered) {
+        return false;
+    }
+    this->m_hovered = role;
+    return true;
+}
+
+bool CaptionButtonStates::press(int role) {
+    if (role == none || role == this->m_pressed) {
+        return false;
+    }
+    this->m_pressed = role;
+    return true;
+}
+
+int CaptionButtonStates::release(int role) {
+    const int pressed = this->m_pressed;
+    this->m_pressed = none;
+    return pressed == role ? pressed : none;
+}
+
+void CaptionButtonStates::reset() {
+    this->m_hovered = none;
+    this->m_pressed = none;
+}
+
+bool CaptionButtonStates::isHovered(TitleBarButton::Role role,
+                                    CaptionButtonStyle style) const {
+    return this->m_hovered == role ||
+           (style == CaptionButtonStyle::mac && this->m_hovered != none);
+}
+
+bool CaptionButtonStates::isPressed(TitleBarButton::Role role) const {
+    return this->m_pressed == role && this->m_hovered == role;
+}
+
+} // namespace CSD::Internal
@@ -0,0 +1,64 @@
+#pragma once
+
+#include "captionbuttonstyle.h"
+#include "csdstylemetrics.h"
+#include "csdtitlebarbutton.h"
+
+#include <QPoint>
+#include <QRect>
+
+#include <array>
+
+namespace CSD::Internal {
+
+// Width of the margin in front of the caption icon
+constexpr int captionLeftMargin = 5;
+
+// Rects of the caption icon and buttons of a title bar that draws them
+// itself, indexed by TitleBarButton::Role. Hidden buttons have null rects.
+// The area in between is left for a menu bar or the title.
+struct CaptionLayout {
+    std::array<QRect, 4> parts;
+    QRect freeArea;
+};
+
+// The geometry a QHBoxLayout gives the caption widgets of a TitleBar.
+// leftMargin is the width of the margin in front of the caption icon, 0 for
+// none.
+CaptionLayout layoutCaption(const QSize &size,
+                            const StyleMetrics &metrics,
+                            int leftMargin,
+                            bool minimizable,
+                            bool maximizable,
+                            Qt::LayoutDirection direction);
+
+// Hover and press state of the three caption buttons, shared by the painted
+// TitleBar and QuickTitleBar
+class CaptionButtonStates {
+public:
+    static constexpr int none = -1;
+
+    int hovered() const;
+    int pressed() const;
+
+    // Returns the button under pos, or none
+    static int buttonAt(const CaptionLayout &layout, const QPoint &pos);
+
+    // Both return whether the buttons have to be repainted
+    bool setHovered(int role);
+    bool press(int role);
+    // Returns the pressed button if it is released over itself, none
+    // otherwise
+    int release(int role);
+    void reset();
+
+    // In mac style every button looks hovered while any of them is
+    bool isHovered(TitleBarButton::Role role, CaptionButtonStyle style) const;
+    bool isPressed(TitleBarButton::Role role) const;
+
+private:
+    int m_hovered = none;
+    int m_pressed = none;
+};
+
+} // namespace CSD::Internal
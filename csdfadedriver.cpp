@@ -0,0 +1,156 @@
+#include "csdfadedriver.h"
+
+#include <QEvent>
+#include <QWidget>
+
+#include <cmath>
+
+namespace CSD::Internal {
+
+FadeDriver::FadeDriver(QWidget *titleBar, Instrumentation::Counters *counters)
+    : QObject(titleBar), m_titleBar(titleBar), m_counters(counters) {
+    this->m_clock.start();
+}
+
+void FadeDriver::setRunning(Slot &slot, bool running) {
+    if (slot.running == running) {
+        return;
+    }
+    slot.running = running;
+    this->m_running += running ? 1 : -1;
+    Instrumentation::count(this->m_counters,
+                           running ? Instrumentation::HoverAnimationStarts
+                                   : Instrumentation::HoverAnimationStops);
+}
+
+void FadeDriver::fadeTo(TitleBarButton *button, double target) {
+    auto &slot = this->m_slots[static_cast<std::size_t>(button->role())];
+    const double current = button->fader();
+    if (std::abs(target - current) < 1e-3) {
+        this->stop(button);
+        return;
+    }
+
+    // Retargeting mid-fade continues from the current value and only takes
+    // the remaining share of the full duration.
+    slot.button = button;
+    slot.from = current;
+    slot.to = target;
+    slot.startMs = this->m_suspended ? this->m_suspendedAtMs
+                                     : this->m_clock.elapsed();
+    slot.durationMs = static_cast<qint64>(
+        std::ceil(std::abs(target - current) * fadeDurationMs));
+    this->setRunning(slot, true);
+    if (!this->m_suspended) {
+        this->requestFrame();
+    }
+}
+
+void FadeDriver::stop(TitleBarButton *button) {
+    auto &slot = this->m_slots[static_cast<std::size_t>(button->role())];
+    this->setRunning(slot, false);
+}
+
+bool FadeDriver::isAnimating() const {
+    return this->m_running > 0;
+}
+
+void FadeDriver::suspend() {
+    if (this->m_suspended) {
+        return;
+    }
+    this->m_suspended = true;
+    this->m_suspendedAtMs = this->m_clock.elapsed();
+}
+
+void FadeDriver::resume() {
+    if (!this->m_suspended) {
+        return;
+    }
+    this->m_suspended = false;
+    const qint64 pausedMs = this->m_clock.elapsed() - this->m_suspendedAtMs;
+    for (auto &slot : this->m_slots) {
+        if (slot.running) {
+            slot.startMs += pausedMs;
+        }
+    }
+    if (this->m_running > 0) {
+        this->requestFrame();
+    }
+}
+
+bool FadeDriver::isSuspended() const {
+    return this->m_suspended;
+}
+
+void FadeDriver::requestFrame() {
+    auto *window = this->m_titleBar->window()->windowHandle();
+    if (window != this->m_window) {
+        if (this->m_window != nullptr) {
+            this->m_window->removeEventFilter(this);
+        }
+        this->m_window = window;
+        this->m_frameRequested = false;
+        if (window != nullptr) {
+            window->installEventFilter(this);
+        }
+    }
+    if (window == nullptr) {
+        // Nothing is on screen yet, skip straight to the targets
+        for (auto &slot : this->m_slots) {
+            if (slot.running) {
+                this->setRunning(slot, false);
+                slot.button->setFader(slot.to);
+            }
+        }
+        return;
+    }
+    if (!this->m_frameRequested) {
+        this->m_frameRequested = true;
+        window->requestUpdate();
+    }
+}
+
+bool FadeDriver::eventFilter(QObject *watched, QEvent *event) {
+    if (watched != this->m_window || event->type() != QEvent::UpdateRequest ||
+        !this->m_frameRequested) {
+        return QObject::eventFilter(watched, event);
+    }
+    this->m_frameRequested = false;
+    if (this->m_suspended || this->m_running == 0) {
+        return true;
+    }
+    // Platforms without frame callbacks deliver update requests every few
+    // milliseconds, the fades advance at most once per frame interval
+    if (this->m_clock.elapsed() - this->m_lastTickMs >= frameIntervalMs) {
+        this->tick();
+    }
+    if (this->m_running > 0) {
+        this->requestFrame();
+    }
+    // QWidgetWindow answers an update request with a repaint of the whole
+    // window. The buttons touched in this tick already scheduled their own
+    // updates, which the backing store flushes together.
+    return true;
+}
+
+void FadeDriver::tick() {
+    const qint64 now = this->m_clock.elapsed();
+    this->m_lastTickMs = now;
+    for (auto &slot : this->m_slots) {
+        if (!slot.running) {
+            continue;
+        }
+        const qint64 elapsed = now - slot.startMs;
+        if (elapsed >= slot.durationMs) {
+            this->setRunning(slot, false);
+            slot.button->setFader(slot.to);
+            continue;
+        }
+        const double progress =
+            static_cast<double>(elapsed) / static_cast<double>(slot.durationMs);
+        slot.button->setFader(slot.from + (slot.to - slot.from) * progress);
+    }
+}
+
+} // namespace CSD::Internal
@@ -0,0 +1,66 @@
+#pragma once
+
+#include "csdinstrumentation.h"
+#include "csdtitlebarbutton.h"
+
+#include <QElapsedTimer>
+#include <QObject>
+#include <QPointer>
+#include <QWindow>
+
+#include <array>
+
+namespace CSD::Internal {
+
+// Drives the hover fades of all caption buttons of one TitleBar. Every
+// button role owns a fixed slot that is retargeted in place, and all running
+// fades advance together on the update requests of the title bar's window,
+// which are only requested while something is animating.
+class FadeDriver final : public QObject {
+    Q_OBJECT
+
+public:
+    static constexpr int fadeDurationMs = 125;
+    static constexpr int frameIntervalMs = 16;
+
+    explicit FadeDriver(QWidget *titleBar,
+                        Instrumentation::Counters *counters = nullptr);
+
+    void fadeTo(TitleBarButton *button, double target);
+    void stop(TitleBarButton *button);
+    bool isAnimating() const;
+
+    // Freezes all fades in place, resume() continues them where they were
+    void suspend();
+    void resume();
+    bool isSuspended() const;
+
+    bool eventFilter(QObject *watched, QEvent *event) override;
+
+private:
+    struct Slot {
+        TitleBarButton *button = nullptr;
+        double from = 0.0;
+        double to = 0.0;
+        qint64 startMs = 0;
+        qint64 durationMs = 0;
+        bool running = false;
+    };
+
+    void tick();
+    void setRunning(Slot &slot, bool running);
+    void requestFrame();
+
+    QWidget *m_titleBar;
+    std::array<Slot, 4> m_slots;
+    QPointer<QWindow> m_window;
+    bool m_frameRequested = false;
+    qint64 m_lastTickMs = 0;
+    QElapsedTimer m_clock;
+    int m_running = 0;
+    bool m_suspended = false;
+    qint64 m_suspendedAtMs = 0;
+    Instrumentation::Counters *m_counters;
+};
+
+} // namespace CSD::Internal
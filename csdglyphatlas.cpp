@@ -0,0 +1,64 @@
+#include "csdglyphatlas.h"
+
+#include "csdglyphraster.h"
+#include "csdtitlebar.h"
+
+#ifdef CSD_GLYPH_ATLAS
+#include "csdglyphatlasdata.h"
+#endif
+
+namespace CSD::Internal {
+
+const QImage &glyphAtlas() {
+#ifdef CSD_GLYPH_ATLAS
+    static const auto atlas = QImage(
+        reinterpret_cast<const uchar *>(glyphAtlasPixels.data()),
+        glyphAtlasWidth,
+        glyphAtlasHeight,
+        glyphAtlasWidth * static_cast<int>(sizeof(quint32)),
+        QImage::Format_ARGB32_Premultiplied);
+#else
+    static const auto atlas = QImage();
+#endif
+    return atlas;
+}
+
+QRect glyphAtlasRect(CaptionButtonStyle style,
+                     TitleBarButton::Role role,
+                     bool active,
+                     bool maximized,
+                     bool hovered,
+                     bool pressed,
+                     qreal devicePixelRatio,
+                     const QSize &iconSize) {
+#ifdef CSD_GLYPH_ATLAS
+    if (role == TitleBarButton::CaptionIcon ||
+        iconSize != QSize(glyphAtlasIconSize, glyphAtlasIconSize)) {
+        return QRect();
+    }
+    const int dprPercent = dprToPercent(devicePixelRatio);
+    for (std::size_t scale = 0; scale < glyphAtlasScaleCount; ++scale) {
+        if (glyphAtlasScalePercents[scale] != dprPercent) {
+            continue;
+        }
+        const auto index =
+            captionStateIndex(active, maximized, hovered, pressed, style) *
+                3 +
+            static_cast<std::size_t>(role - TitleBarButton::Minimize);
+        const auto &rect = glyphAtlasRects[scale][index];
+        return QRect(rect[0], rect[1], rect[2], rect[3]);
+    }
+#else
+    Q_UNUSED(style)
+    Q_UNUSED(role)
+    Q_UNUSED(active)
+    Q_UNUSED(maximized)
+    Q_UNUSED(hovered)
+    Q_UNUSED(pressed)
+    Q_UNUSED(devicePixelRatio)
+    Q_UNUSED(iconSize)
+#endif
+    return QRect();
+}
+
+} // namespace CSD::Internal
@@ -0,0 +1,28 @@
+#pragma once
+
+#include "captionbuttonstyle.h"
+#include "csdtitlebarbutton.h"
+
+#include <QImage>
+#include <QRect>
+#include <QSize>
+
+namespace CSD::Internal {
+
+// Caption glyphs baked into the binary at build time (see
+// buildutils/generate_glyph_atlas.cpp). The atlas image wraps the embedded
+// pixels without copying them.
+const QImage &glyphAtlas();
+
+// Source rect of a glyph in glyphAtlas(), or a null rect if this icon size
+// and device pixel ratio were not baked and the glyph has to be rasterized.
+QRect glyphAtlasRect(CaptionButtonStyle style,
+                     TitleBarButton::Role role,
+                     bool active,
+                     bool maximized,
+                     bool hovered,
+                     bool pressed,
+                     qreal devicePixelRatio,
+                     const QSize &iconSize);
+
+} // namespace CSD::Internal
@@ -0,0 +1,522 @@
+#include "csdglyphcache.h"
+
+#include "csdglyphatlas.h"
+#include "csdinstrumentation.h"
+#include "csdpixelkernels.h"
+#include "csdtitlebar.h"
+
+#include <QGuiApplication>
+#include <QHash>
+#include <QPainter>
+#include <QPointer>
+#include <QRunnable>
+#include <QScreen>
+#include <QStyle>
+#include <QThreadPool>
+
+#include <algorithm>
+#include <cmath>
+#include <functional>
+
+namespace CSD::Internal {
+
+constexpr static int defaultCacheLimitKb = 2048;
+
+namespace {
+
+// Glyph colors for dark and for light backgrounds
+struct GlyphPalette {
+    QRgb normal;
+    QRgb muted;
+    QRgb emphasized;
+};
+
+constexpr GlyphPalette lightGlyphs = {0xffabb2bf, 0xff5c6370, 0xffffffff};
+constexpr GlyphPalette darkGlyphs = {0xff383a42, 0xffa0a1a7, 0xff000000};
+
+// Relative luminance as defined by WCAG 2
+qreal relativeLuminance(const QColor &color) {
+    const auto linear = [](qreal channel) {
+        return channel <= 0.03928 ? channel / 12.92
+                                  : std::pow((channel + 0.055) / 1.055, 2.4);
+    };
+    return 0.2126 * linear(color.redF()) + 0.7152 * linear(color.greenF()) +
+           0.0722 * linear(color.blueF());
+}
+
+// What shows through a translucent fill painted over an opaque background
+QColor composite(const QColor &fill, const QColor &background) {
+    const qreal alpha = fill.alphaF();
+    return QColor::fromRgbF(
+        fill.redF() * alpha + background.redF() * (1 - alpha),
+        fill.greenF() * alpha + background.greenF() * (1 - alpha),
+        fill.blueF() * alpha + background.blueF() * (1 - alpha));
+}
+
+// Masks only depend on the glyph, not on the caption state
+GlyphKey maskKey(CaptionButtonStyle style,
+                 TitleBarButton::Role role,
+                 bool maximized,
+                 int dprPercent,
+                 const QSize &iconSize) {
+    return GlyphKey{style,
+                    role,
+                    false,
+                    maximized && role == TitleBarButton::MaximizeRestore,
+                    false,
+                    false,
+                    dprPercent,
+                    iconSize,
+                    0};
+}
+
+// One asset and every cache key it is drawn for
+struct PrewarmJob {
+    QString path;
+    std::vector<GlyphKey> keys;
+};
+
+class PrewarmTask final : public QRunnable {
+public:
+    using Deliver =
+        std::function<void(std::vector<GlyphKey> keys, QImage image)>;
+
+    PrewarmTask(qreal devicePixelRatio,
+                const QSize &iconSize,
+                std::vector<PrewarmJob> jobs,
+                Deliver deliver)
+        : m_devicePixelRatio(devicePixelRatio), m_iconSize(iconSize),
+          m_jobs(std::move(jobs)), m_deliver(std::move(deliver)) {}
+
+    void run() override {
+        const auto span = Instrumentation::TraceSpan("GlyphCache prewarm");
+        for (auto &job : this->m_jobs) {
+            auto image = rasterizeGlyphImage(
+                job.path, this->m_devicePixelRatio, this->m_iconSize);
+            if (!image.isNull()) {
+                this->m_deliver(std::move(job.keys), std::move(image));
+            }
+        }
+    }
+
+private:
+    qreal m_devicePixelRatio;
+    QSize m_iconSize;
+    std::vector<PrewarmJob> m_jobs;
+    Deliver m_deliver;
+};
+
+} // namespace
+
+bool GlyphKey::operator==(const GlyphKey &other) const {
+    return this->style == other.style && this->role == other.role &&
+           this->active == other.active &&
+           this->maximized == other.maximized &&
+           this->hovered == other.hovered && this->pressed == other.pressed &&
+           this->dprPercent == other.dprPercent &&
+           this->iconSize == other.iconSize && this->tint == other.tint;
+}
+
+uint qHash(const GlyphKey &key, uint seed) {
+    const auto bits =
+        (static_cast<uint>(key.style) << 6) |
+        (static_cast<uint>(key.role) << 4) |
+        (static_cast<uint>(key.active) << 3) |
+        (static_cast<uint>(key.maximized) << 2) |
+        (static_cast<uint>(key.hovered) << 1) | static_cast<uint>(key.pressed);
+    return ::qHash(bits, seed) ^ ::qHash(key.dprPercent, seed) ^
+           (::qHash(key.iconSize.width(), seed) << 1) ^
+           ::qHash(key.iconSize.height(), seed) ^ ::qHash(key.tint, seed);
+}
+
+QColor captionGlyphTint(CaptionButtonStyle style,
+                        TitleBarButton::Role role,
+                        bool active,
+                        bool hovered,
+                        const QColor &titleBarColor,
+                        const QColor &hoverFill) {
+    if (!isTintedStyle(style)) {
+        return QColor();
+    }
+    const auto background =
+        hovered ? composite(hoverFill, titleBarColor) : titleBarColor;
+    // Below this luminance white contrasts more than black
+    const auto &palette =
+        relativeLuminance(background) < 0.179 ? lightGlyphs : darkGlyphs;
+    if (hovered && role == TitleBarButton::Close) {
+        return QColor::fromRgba(palette.emphasized);
+    }
+    return QColor::fromRgba(active || hovered ? palette.normal
+                                              : palette.muted);
+}
+
+GlyphCache &GlyphCache::instance() {
+    // Owned by the application so the pixmaps die before the GUI does
+    static QPointer<GlyphCache> cache;
+    if (cache.isNull()) {
+        cache = new GlyphCache(qApp);
+    }
+    return *cache;
+}
+
+GlyphCache::GlyphCache(QObject *parent)
+    : QObject(parent), m_pixmaps(defaultCacheLimitKb) {
+    for (QScreen *screen : QGuiApplication::screens()) {
+        this->trackScreen(screen);
+    }
+    connect(qApp,
+            &QGuiApplication::screenAdded,
+            this,
+            [this](QScreen *screen) { this->trackScreen(screen); });
+    connect(qApp,
+            &QGuiApplication::screenRemoved,
+            this,
+            [this](QScreen *screen) {
+                auto it = this->m_screenDprPercent.find(screen);
+                if (it == std::end(this->m_screenDprPercent)) {
+                    return;
+                }
+                const int dprPercent = it->second;
+                this->m_screenDprPercent.erase(it);
+                this->invalidateDevicePixelRatio(dprPercent);
+            });
+}
+
+void GlyphCache::trackScreen(QScreen *screen) {
+    this->m_screenDprPercent[screen] =
+        dprToPercent(screen->devicePixelRatio());
+    // Qt 5 has no devicePixelRatioChanged signal, the DPR follows the logical
+    // DPI and the geometry when the high DPI scale factor is recomputed.
+    const auto check = [this, screen]() {
+        this->onScreenDevicePixelRatioMaybeChanged(screen);
+    };
+    connect(screen, &QScreen::logicalDotsPerInchChanged, this, check);
+    connect(screen, &QScreen::physicalDotsPerInchChanged, this, check);
+    connect(screen, &QScreen::geometryChanged, this, check);
+}
+
+void GlyphCache::onScreenDevicePixelRatioMaybeChanged(QScreen *screen) {
+    auto it = this->m_screenDprPercent.find(screen);
+    if (it == std::end(this->m_screenDprPercent)) {
+        return;
+    }
+    const int newDprPercent = dprToPercent(screen->devicePixelRatio());
+    const int oldDprPercent = it->second;
+    if (newDprPercent == oldDprPercent) {
+        return;
+    }
+    it->second = newDprPercent;
+    this->invalidateDevicePixelRatio(oldDprPercent);
+}
+
+void GlyphCache::invalidateDevicePixelRatio(int dprPercent) {
+    // Another screen may still render at the old ratio
+    for (const auto &pair : this->m_screenDprPercent) {
+        if (pair.second == dprPercent) {
+            return;
+        }
+    }
+    for (const GlyphKey &key : this->m_pixmaps.keys()) {
+        if (key.dprPercent == dprPercent) {
+            this->m_pixmaps.remove(key);
+        }
+    }
+    for (auto it = std::begin(this->m_masks);
+         it != std::end(this->m_masks);) {
+        it = it.key().dprPercent == dprPercent ? this->m_masks.erase(it)
+                                               : std::next(it);
+    }
+    for (auto it = std::begin(this->m_prewarmed);
+         it != std::end(this->m_prewarmed);) {
+        it = std::get<1>(*it) == dprPercent ? this->m_prewarmed.erase(it)
+                                            : std::next(it);
+    }
+}
+
+void GlyphCache::insertPixmap(const GlyphKey &key, const QPixmap &pixmap) {
+    const int costKb =
+        qMax(1, pixmap.width() * pixmap.height() * pixmap.depth() / 8 / 1024);
+    this->m_pixmaps.insert(key, new QPixmap(pixmap), costKb);
+}
+
+void GlyphCache::prewarm(CaptionButtonStyle style, const QSize &iconSize) {
+    if (iconSize.isEmpty()) {
+        return;
+    }
+    auto dprPercents = std::set<int>();
+    for (const auto &pair : this->m_screenDprPercent) {
+        dprPercents.insert(pair.second);
+    }
+
+    for (const int dprPercent : dprPercents) {
+        const auto prewarmKey = PrewarmKey(
+            style, dprPercent, iconSize.width(), iconSize.height());
+        if (!this->m_prewarmed.insert(prewarmKey).second) {
+            continue;
+        }
+        const qreal devicePixelRatio = dprPercent / 100.0;
+        auto jobs = std::vector<PrewarmJob>();
+        auto jobIndices = QHash<QString, std::size_t>();
+        // Bit 3 active, bit 2 maximized, bit 1 hovered, bit 0 pressed
+        for (unsigned state = 0; state < 16; ++state) {
+            const bool active = state & 8U;
+            const bool maximized = state & 4U;
+            const bool hovered = state & 2U;
+            const bool pressed = state & 1U;
+            const auto paths = captionIconPathsForState(
+                active, maximized, hovered, pressed, style);
+            for (const auto role : {TitleBarButton::Minimize,
+                                    TitleBarButton::MaximizeRestore,
+                                    TitleBarButton::Close}) {
+                const bool tinted = isTintedStyle(style);
+                const auto key =
+                    tinted ? maskKey(
+                                 style, role, maximized, dprPercent, iconSize)
+                           : GlyphKey{style,
+                                      role,
+                                      active,
+                                      maximized,
+                                      hovered,
+                                      pressed,
+                                      dprPercent,
+                                      iconSize,
+                                      0};
+                const bool cached = tinted ? this->m_masks.contains(key)
+                                           : this->m_pixmaps.contains(key);
+                if (cached || !glyphAtlasRect(style,
+                                              role,
+                                              active,
+                                              maximized,
+                                              hovered,
+                                              pressed,
+                                              devicePixelRatio,
+                                              iconSize)
+                                   .isNull()) {
+                    continue;
+                }
+                const auto path =
+                    paths[static_cast<std::size_t>(
+                              role - TitleBarButton::Minimize)]
+                        .toString();
+                auto it = jobIndices.find(path);
+                if (it == std::end(jobIndices)) {
+                    it = jobIndices.insert(path, jobs.size());
+                    jobs.push_back(PrewarmJob{path, {}});
+                }
+                auto &keys = jobs[it.value()].keys;
+                if (std::find(std::begin(keys), std::end(keys), key) ==
+                    std::end(keys)) {
+                    keys.push_back(key);
+                }
+            }
+        }
+        if (jobs.empty()) {
+            continue;
+        }
+
+        auto deliver = [cache = QPointer<GlyphCache>(this), prewarmKey](
+                           std::vector<GlyphKey> keys, QImage image) {
+            QMetaObject::invokeMethod(
+                QCoreApplication::instance(),
+                [cache,
+                 prewarmKey,
+                 keys = std::move(keys),
+                 image = std::move(image)]() {
+                    // Dropped if the scale went away in the meantime
+                    if (cache.isNull() ||
+                        cache->m_prewarmed.count(prewarmKey) == 0) {
+                        return;
+                    }
+                    if (isTintedStyle(std::get<0>(prewarmKey))) {
+                        const auto mask = image.convertToFormat(
+                            QImage::Format_ARGB32_Premultiplied);
+                        for (const auto &key : keys) {
+                            if (!cache->m_masks.contains(key)) {
+                                cache->m_masks.insert(key, mask);
+                            }
+                        }
+                        return;
+                    }
+                    const auto pixmap = QPixmap::fromImage(image);
+                    for (const auto &key : keys) {
+                        if (!cache->m_pixmaps.contains(key)) {
+                            cache->insertPixmap(key, pixmap);
+                        }
+                    }
+                },
+                Qt::QueuedConnection);
+        };
+        QThreadPool::globalInstance()->start(
+            new PrewarmTask(devicePixelRatio,
+                            iconSize,
+                            std::move(jobs),
+                            std::move(deliver)));
+    }
+}
+
+QImage GlyphCache::mask(CaptionButtonStyle style,
+                        TitleBarButton::Role role,
+                        bool maximized,
+                        qreal devicePixelRatio,
+                        const QSize &iconSize) {
+    const auto key = maskKey(
+        style, role, maximized, dprToPercent(devicePixelRatio), iconSize);
+    const auto it = this->m_masks.constFind(key);
+    if (it != std::cend(this->m_masks)) {
+        return it.value();
+    }
+
+    auto image = QImage();
+    const auto atlasRect = glyphAtlasRect(style,
+                                          role,
+                                          false,
+                                          maximized,
+                                          false,
+                                          false,
+                                          devicePixelRatio,
+                                          iconSize);
+    if (!atlasRect.isNull()) {
+        image = glyphAtlas().copy(atlasRect);
+        image.setDevicePixelRatio(devicePixelRatio);
+    } else {
+        const auto iconPaths =
+            captionIconPathsForState(false, maximized, false, false, style);
+        const auto index =
+            static_cast<std::size_t>(role - TitleBarButton::Minimize);
+        image = rasterizeGlyphImage(
+                    iconPaths[index].toString(), devicePixelRatio, iconSize)
+                    .convertToFormat(QImage::Format_ARGB32_Premultiplied);
+    }
+    if (!image.isNull()) {
+        this->m_masks.insert(key, image);
+    }
+    return image;
+}
+
+QPixmap GlyphCache::glyph(CaptionButtonStyle style,
+                          TitleBarButton::Role role,
+                          bool active,
+                          bool maximized,
+                          bool hovered,
+                          bool pressed,
+                          qreal devicePixelRatio,
+                          const QSize &iconSize,
+                          const QColor &tint) {
+    if (role == TitleBarButton::CaptionIcon || iconSize.isEmpty()) {
+        return QPixmap();
+    }
+
+    const int dprPercent = dprToPercent(devicePixelRatio);
+    if (isTintedStyle(style)) {
+        // The state only matters through the tint
+        auto key = maskKey(style, role, maximized, dprPercent, iconSize);
+        key.tint = tint.rgba();
+        if (const QPixmap *cached = this->m_pixmaps.object(key)) {
+            return *cached;
+        }
+        const auto glyphMask =
+            this->mask(style, role, maximized, devicePixelRatio, iconSize);
+        if (glyphMask.isNull()) {
+            return QPixmap();
+        }
+        const auto pixmap = QPixmap::fromImage(tintImage(glyphMask, tint));
+        this->insertPixmap(key, pixmap);
+        return pixmap;
+    }
+
+    const auto key = GlyphKey{style,
+                              role,
+                              active,
+                              maximized,
+                              hovered,
+                              pressed,
+                              dprPercent,
+                              iconSize,
+                              0};
+    if (const QPixmap *cached = this->m_pixmaps.object(key)) {
+        return *cached;
+    }
+
+    const auto iconPaths = captionIconPathsForState(
+        active, maximized, hovered, pressed, style);
+    const auto index =
+        static_cast<std::size_t>(role - TitleBarButton::Minimize);
+    auto pixmap = rasterizeGlyph(
+        iconPaths[index].toString(), devicePixelRatio, iconSize);
+    if (pixmap.isNull()) {
+        return pixmap;
+    }
+
+    this->insertPixmap(key, pixmap);
+    return pixmap;
+}
+
+int GlyphCache::cacheLimit() const {
+    return this->m_pixmaps.maxCost();
+}
+
+void GlyphCache::setCacheLimit(int kilobytes) {
+    this->m_pixmaps.setMaxCost(kilobytes);
+}
+
+int GlyphCache::cacheCost() const {
+    return this->m_pixmaps.totalCost();
+}
+
+void GlyphCache::clear() {
+    this->m_pixmaps.clear();
+    this->m_masks.clear();
+    this->m_prewarmed.clear();
+}
+
+void drawCaptionGlyph(QPainter &painter,
+                      const QRect &rect,
+                      Qt::LayoutDirection direction,
+                      CaptionButtonStyle style,
+                      TitleBarButton::Role role,
+                      bool active,
+                      bool maximized,
+                      bool hovered,
+                      bool pressed,
+                      qreal devicePixelRatio,
+                      const QSize &iconSize,
+                      const QColor &tint) {
+    const auto atlasRect = isTintedStyle(style)
+                               ? QRect()
+                               : glyphAtlasRect(style,
+                                                role,
+                                                active,
+                                                maximized,
+                                                hovered,
+                                                pressed,
+                                                devicePixelRatio,
+                                                iconSize);
+    if (!atlasRect.isNull()) {
+        const auto glyphRect =
+            QStyle::alignedRect(direction,
+                                Qt::AlignCenter,
+                                atlasRect.size() / devicePixelRatio,
+                                rect);
+        painter.drawImage(glyphRect, glyphAtlas(), atlasRect);
+        return;
+    }
+
+    const auto glyph = GlyphCache::instance().glyph(style,
+                                                    role,
+                                                    active,
+                                                    maximized,
+                                                    hovered,
+                                                    pressed,
+                                                    devicePixelRatio,
+                                                    iconSize,
+                                                    tint);
+    if (glyph.isNull()) {
+        return;
+    }
+    const auto glyphSize = glyph.size() / glyph.devicePixelRatio();
+    const auto glyphRect =
+        QStyle::alignedRect(direction, Qt::AlignCenter, glyphSize, rect);
+    painter.drawPixmap(glyphRect.topLeft(), glyph);
+}
+
+} // namespace CSD::Internal
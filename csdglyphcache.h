@@ -0,0 +1,130 @@
+#pragma once
+
+#include "captionbuttonstyle.h"
+#include "csdglyphraster.h"
+#include "csdtitlebarbutton.h"
+
+#include <QCache>
+#include <QColor>
+#include <QHash>
+#include <QImage>
+#include <QObject>
+#include <QPixmap>
+#include <QRect>
+#include <QSize>
+
+#include <set>
+#include <tuple>
+#include <unordered_map>
+#include <vector>
+
+class QPainter;
+class QScreen;
+
+namespace CSD::Internal {
+
+struct GlyphKey {
+    CaptionButtonStyle style;
+    TitleBarButton::Role role;
+    bool active;
+    bool maximized;
+    bool hovered;
+    bool pressed;
+    int dprPercent;
+    QSize iconSize;
+    // Color of a tinted glyph, 0 for masks and untinted glyphs
+    QRgb tint;
+
+    bool operator==(const GlyphKey &other) const;
+};
+
+uint qHash(const GlyphKey &key, uint seed = 0);
+
+// Whether the glyphs of a style are alpha masks tinted at runtime. The mac
+// style ships colored artwork that is drawn as is.
+constexpr bool isTintedStyle(CaptionButtonStyle style) {
+    return style != CaptionButtonStyle::mac;
+}
+
+// Color of a tinted glyph: light or dark, whichever contrasts more with what
+// is behind it, the title bar or the button's hover fill over it. Inactive
+// glyphs are muted. Returns an invalid color for styles that are not tinted.
+QColor captionGlyphTint(CaptionButtonStyle style,
+                        TitleBarButton::Role role,
+                        bool active,
+                        bool hovered,
+                        const QColor &titleBarColor,
+                        const QColor &hoverFill);
+
+// Process-wide cache of rasterized caption glyphs. Every TitleBarButton
+// looks its glyph up here, so a hover repaint is a hash lookup plus a blit
+// instead of a trip through the SVG icon engine. Tinted styles decode one
+// mask per glyph and scale, every color is a single pass over it.
+class GlyphCache final : public QObject {
+    Q_OBJECT
+
+public:
+    static GlyphCache &instance();
+
+    QPixmap glyph(CaptionButtonStyle style,
+                  TitleBarButton::Role role,
+                  bool active,
+                  bool maximized,
+                  bool hovered,
+                  bool pressed,
+                  qreal devicePixelRatio,
+                  const QSize &iconSize,
+                  const QColor &tint = QColor());
+
+    // Rasterizes the glyphs of a style that the baked atlas does not cover
+    // on the global QThreadPool, at the scale of every screen. The images
+    // are cached on the GUI thread as they arrive, as masks for tinted
+    // styles and as pixmaps otherwise, so the first hover does not have to
+    // decode anything.
+    void prewarm(CaptionButtonStyle style, const QSize &iconSize);
+
+    // Memory budget in kilobytes, like QPixmapCache::setCacheLimit().
+    int cacheLimit() const;
+    void setCacheLimit(int kilobytes);
+    // Kilobytes currently held
+    int cacheCost() const;
+    void clear();
+
+private:
+    explicit GlyphCache(QObject *parent = nullptr);
+    void trackScreen(QScreen *screen);
+    void onScreenDevicePixelRatioMaybeChanged(QScreen *screen);
+    void invalidateDevicePixelRatio(int dprPercent);
+    void insertPixmap(const GlyphKey &key, const QPixmap &pixmap);
+    QImage mask(CaptionButtonStyle style,
+                TitleBarButton::Role role,
+                bool maximized,
+                qreal devicePixelRatio,
+                const QSize &iconSize);
+
+    QCache<GlyphKey, QPixmap> m_pixmaps;
+    // A handful of small images, kept for as long as their scale is in use
+    QHash<GlyphKey, QImage> m_masks;
+    // Style, scale percent and icon size of every prewarm already scheduled
+    using PrewarmKey = std::tuple<CaptionButtonStyle, int, int, int>;
+    std::set<PrewarmKey> m_prewarmed;
+    std::unordered_map<QScreen *, int> m_screenDprPercent;
+};
+
+// Draws a caption glyph centered in rect. Untinted glyphs come straight from
+// the baked atlas when it has this icon size and scale, everything else goes
+// through the GlyphCache.
+void drawCaptionGlyph(QPainter &painter,
+                      const QRect &rect,
+                      Qt::LayoutDirection direction,
+                      CaptionButtonStyle style,
+                      TitleBarButton::Role role,
+                      bool active,
+                      bool maximized,
+                      bool hovered,
+                      bool pressed,
+                      qreal devicePixelRatio,
+                      const QSize &iconSize,
+                      const QColor &tint);
+
+} // namespace CSD::Internal
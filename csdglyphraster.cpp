@@ -0,0 +1,61 @@
+#include "csdglyphraster.h"
+
+#include "csdinstrumentation.h"
+
+#include <QFileInfo>
+#include <QImageReader>
+
+#include <cmath>
+
+namespace CSD::Internal {
+
+int dprToPercent(qreal devicePixelRatio) {
+    return static_cast<int>(std::lround(devicePixelRatio * 100.0));
+}
+
+QImage rasterizeGlyphImage(const QString &path,
+                           qreal devicePixelRatio,
+                           const QSize &iconSize) {
+    auto image = QImage();
+    auto source = path;
+    // Raster assets ship an @2x variant, prefer it on high DPI screens
+    const auto fileInfo = QFileInfo(path);
+    if (devicePixelRatio > 1.0 && fileInfo.suffix() != QLatin1String("svg")) {
+        const auto highDpiPath = fileInfo.path() + QLatin1Char('/') +
+                                 fileInfo.completeBaseName() +
+                                 QLatin1String("@2x.") + fileInfo.suffix();
+        if (QFileInfo::exists(highDpiPath)) {
+            source = highDpiPath;
+        }
+    }
+
+    auto reader = QImageReader(source);
+    const auto physicalSize = iconSize * devicePixelRatio;
+    auto targetSize = reader.size();
+    if (targetSize.isValid()) {
+        targetSize.scale(physicalSize, Qt::KeepAspectRatio);
+    } else {
+        targetSize = physicalSize;
+    }
+    reader.setScaledSize(targetSize);
+    Instrumentation::count(Instrumentation::GlyphLoads);
+    if (!reader.read(&image)) {
+        return QImage();
+    }
+    image.setDevicePixelRatio(devicePixelRatio);
+    return image;
+}
+
+QPixmap rasterizeGlyph(const QString &path,
+                       qreal devicePixelRatio,
+                       const QSize &iconSize) {
+    auto image = rasterizeGlyphImage(path, devicePixelRatio, iconSize);
+    if (image.isNull()) {
+        return QPixmap();
+    }
+    auto pixmap = QPixmap::fromImage(std::move(image));
+    pixmap.setDevicePixelRatio(devicePixelRatio);
+    return pixmap;
+}
+
+} // namespace CSD::Internal
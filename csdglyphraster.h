@@ -0,0 +1,22 @@
+#pragma once
+
+#include <QImage>
+#include <QPixmap>
+#include <QSize>
+#include <QString>
+
+namespace CSD::Internal {
+
+int dprToPercent(qreal devicePixelRatio);
+
+// Decodes one caption asset at iconSize logical pixels. Used both at runtime
+// and by the build-time glyph atlas generator, so baked and lazily loaded
+// glyphs are pixel identical.
+QImage rasterizeGlyphImage(const QString &path,
+                           qreal devicePixelRatio,
+                           const QSize &iconSize);
+QPixmap rasterizeGlyph(const QString &path,
+                       qreal devicePixelRatio,
+                       const QSize &iconSize);
+
+} // namespace CSD::Internal
@@ -0,0 +1,86 @@
+#include "csdhittest.h"
+
+namespace CSD::Internal {
+
+// Indexed by row * 3 + column, rows and columns are 0 for the leading
+// border, 1 for the inside and 2 for the trailing border
+constexpr static std::array<HitRegion, 9> regionTable = {
+    HitRegion::TopLeft,
+    HitRegion::Top,
+    HitRegion::TopRight,
+    HitRegion::Left,
+    HitRegion::Client,
+    HitRegion::Right,
+    HitRegion::BottomLeft,
+    HitRegion::Bottom,
+    HitRegion::BottomRight,
+};
+
+// Indexed by HitRegion
+constexpr static std::array<Qt::CursorShape, 9> cursorTable = {
+    Qt::ArrowCursor,
+    Qt::SizeHorCursor,
+    Qt::SizeHorCursor,
+    Qt::SizeVerCursor,
+    Qt::SizeVerCursor,
+    Qt::SizeFDiagCursor,
+    Qt::SizeBDiagCursor,
+    Qt::SizeBDiagCursor,
+    Qt::SizeFDiagCursor,
+};
+
+HitTester::HitTester(int borderWidth) : m_borderWidth(borderWidth) {}
+
+int HitTester::borderWidth() const {
+    return this->m_borderWidth;
+}
+
+void HitTester::setBorderWidth(int borderWidth) {
+    this->m_borderWidth = borderWidth;
+    this->updateThresholds();
+}
+
+QSize HitTester::size() const {
+    return this->m_size;
+}
+
+void HitTester::setGeometry(const QSize &size,
+                            bool resizeWidth,
+                            bool resizeHeight) {
+    this->m_size = size;
+    this->m_resizeWidth = resizeWidth;
+    this->m_resizeHeight = resizeHeight;
+    this->updateThresholds();
+}
+
+void HitTester::updateThresholds() {
+    const int width = this->m_size.width();
+    const int height = this->m_size.height();
+    // A direction that cannot be resized gets thresholds no point can cross
+    this->m_leftEdge = this->m_resizeWidth ? this->m_borderWidth : 0;
+    this->m_rightEdge =
+        this->m_resizeWidth ? width - this->m_borderWidth : width;
+    this->m_topEdge = this->m_resizeHeight ? this->m_borderWidth : 0;
+    this->m_bottomEdge =
+        this->m_resizeHeight ? height - this->m_borderWidth : height;
+}
+
+HitRegion HitTester::classify(const QPoint &pos) const {
+    const int x = pos.x();
+    const int y = pos.y();
+    if (x < 0 || y < 0 || x >= this->m_size.width() ||
+        y >= this->m_size.height()) {
+        return HitRegion::Client;
+    }
+    const int column = static_cast<int>(x >= this->m_leftEdge) +
+                       static_cast<int>(x >= this->m_rightEdge);
+    const int row = static_cast<int>(y >= this->m_topEdge) +
+                    static_cast<int>(y >= this->m_bottomEdge);
+    return regionTable[static_cast<std::size_t>(row * 3 + column)];
+}
+
+Qt::CursorShape HitTester::cursorShape(HitRegion region) {
+    return cursorTable[static_cast<std::size_t>(region)];
+}
+
+} // namespace CSD::Internal
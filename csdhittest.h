@@ -0,0 +1,53 @@
+#pragma once
+
+#include <QPoint>
+#include <QSize>
+
+#include <array>
+#include <cstddef>
+
+namespace CSD::Internal {
+
+enum class HitRegion : int {
+    Client,
+    Left,
+    Right,
+    Top,
+    Bottom,
+    TopLeft,
+    TopRight,
+    BottomLeft,
+    BottomRight,
+};
+
+// Classifies window coordinates into the resize borders of a frameless
+// window. The border thresholds are recomputed only when the window geometry
+// changes, classifying a point is a table lookup.
+class HitTester {
+public:
+    static constexpr int defaultBorderWidth = 8;
+
+    explicit HitTester(int borderWidth = defaultBorderWidth);
+
+    int borderWidth() const;
+    void setBorderWidth(int borderWidth);
+    QSize size() const;
+    void setGeometry(const QSize &size, bool resizeWidth, bool resizeHeight);
+    HitRegion classify(const QPoint &pos) const;
+
+    static Qt::CursorShape cursorShape(HitRegion region);
+
+private:
+    void updateThresholds();
+
+    int m_borderWidth;
+    QSize m_size;
+    bool m_resizeWidth = false;
+    bool m_resizeHeight = false;
+    int m_leftEdge = 0;
+    int m_rightEdge = 0;
+    int m_topEdge = 0;
+    int m_bottomEdge = 0;
+};
+
+} // namespace CSD::Internal
@@ -0,0 +1,180 @@
+#include "csdinstrumentation.h"
+
+#include <QCoreApplication>
+#include <QFile>
+
+#include <atomic>
+#include <cstdio>
+#include <mutex>
+#include <vector>
+
+Q_LOGGING_CATEGORY(lcCsdInstrumentation, "csd.instrumentation", QtInfoMsg)
+
+namespace CSD::Instrumentation {
+
+constexpr static std::array<const char *, CounterCount> counterNames = {
+    "titleBarPaints",
+    "titleBarPaintNs",
+    "buttonPaints",
+    "buttonPaintNs",
+    "glyphLoads",
+    "hoverAnimationStarts",
+    "hoverAnimationStops",
+    "palettePropagations",
+    "filterDispatches",
+    "filterDispatchNs",
+    "xcbRoundTrips",
+    "clientMoveMotions",
+    "clientMoveConfigures",
+    "clientMoveLatencyNs",
+};
+
+static std::array<std::atomic<quint64>, CounterCount> &globalValues() {
+    static std::array<std::atomic<quint64>, CounterCount> values{};
+    if constexpr (enabled) {
+        // The totals are logged when the application object is destroyed
+        [[maybe_unused]] static const bool logAtExit =
+            (qAddPostRoutine(logGlobalCounters), true);
+    }
+    return values;
+}
+
+const char *counterName(Counter counter) {
+    return counterNames[counter];
+}
+
+Counters globalCounters() {
+    auto counters = Counters();
+    const auto &values = globalValues();
+    for (std::size_t i = 0; i < CounterCount; ++i) {
+        counters.values[i] = values[i].load(std::memory_order_relaxed);
+    }
+    return counters;
+}
+
+void resetGlobalCounters() {
+    for (auto &value : globalValues()) {
+        value.store(0, std::memory_order_relaxed);
+    }
+}
+
+void addGlobal(Counter counter, qint64 value) {
+    globalValues()[counter].fetch_add(static_cast<quint64>(value),
+                                      std::memory_order_relaxed);
+}
+
+void logCounters(const char *label, const Counters &counters) {
+    if (!lcCsdInstrumentation().isDebugEnabled()) {
+        return;
+    }
+    for (std::size_t i = 0; i < CounterCount; ++i) {
+        qCDebug(lcCsdInstrumentation,
+                "%s %s=%llu",
+                label,
+                counterNames[i],
+                static_cast<unsigned long long>(counters.values[i]));
+    }
+}
+
+void logGlobalCounters() {
+    logCounters("global", globalCounters());
+}
+
+namespace {
+
+struct TraceEvent {
+    const char *name;
+    qint64 startNs;
+    qint64 durationNs;
+    int threadId;
+};
+
+// Collects the spans of all threads and writes them when the process exits
+class TraceRecorder {
+public:
+    TraceRecorder() : m_path(qEnvironmentVariable("CSD_TRACE_FILE")) {
+        this->m_clock.start();
+    }
+    ~TraceRecorder() {
+        this->write();
+    }
+    TraceRecorder(const TraceRecorder &) = delete;
+    TraceRecorder &operator=(const TraceRecorder &) = delete;
+
+    bool enabled() const {
+        return !this->m_path.isEmpty();
+    }
+
+    qint64 clockNs() const {
+        return this->m_clock.nsecsElapsed();
+    }
+
+    void add(const TraceEvent &event) {
+        const auto lock = std::lock_guard<std::mutex>(this->m_mutex);
+        this->m_events.push_back(event);
+    }
+
+private:
+    void write() {
+        if (!this->enabled()) {
+            return;
+        }
+        std::FILE *file =
+            std::fopen(QFile::encodeName(this->m_path).constData(), "w");
+        if (file == nullptr) {
+            return;
+        }
+        const long long pid = QCoreApplication::applicationPid();
+        std::fputs("{\"displayTimeUnit\":\"ms\",\"traceEvents\":[", file);
+        const char *separator = "\n";
+        for (const auto &event : this->m_events) {
+            // Chrome traces count in microseconds
+            std::fprintf(file,
+                         "%s{\"name\":\"%s\",\"cat\":\"csd\",\"ph\":\"X\","
+                         "\"ts\":%.3f,\"dur\":%.3f,\"pid\":%lld,"
+                         "\"tid\":%d}",
+                         separator,
+                         event.name,
+                         static_cast<double>(event.startNs) / 1000.0,
+                         static_cast<double>(event.durationNs) / 1000.0,
+                         pid,
+                         event.threadId);
+            separator = ",\n";
+        }
+        std::fputs("\n]}\n", file);
+        std::fclose(file);
+    }
+
+    QString m_path;
+    QElapsedTimer m_clock;
+    std::mutex m_mutex;
+    std::vector<TraceEvent> m_events;
+};
+
+} // namespace
+
+static TraceRecorder &traceRecorder() {
+    static TraceRecorder recorder;
+    return recorder;
+}
+
+static int traceThreadId() {
+    static std::atomic<int> nextThreadId{1};
+    thread_local const int threadId = nextThreadId.fetch_add(1);
+    return threadId;
+}
+
+bool traceEnabled() {
+    return traceRecorder().enabled();
+}
+
+qint64 traceClockNs() {
+    return traceRecorder().clockNs();
+}
+
+void addTraceEvent(const char *name, qint64 startNs, qint64 durationNs) {
+    traceRecorder().add(
+        TraceEvent{name, startNs, durationNs, traceThreadId()});
+}
+
+} // namespace CSD::Instrumentation
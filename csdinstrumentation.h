@@ -0,0 +1,140 @@
+#pragma once
+
+#include <QElapsedTimer>
+#include <QLoggingCategory>
+#include <QtGlobal>
+
+#include <array>
+#include <cstddef>
+
+Q_DECLARE_LOGGING_CATEGORY(lcCsdInstrumentation)
+
+// Opt-in performance counters of the decoration layer. Counting is compiled
+// in only when CSD_INSTRUMENTATION is defined (the CMake option of the same
+// name), otherwise every hook below is an empty inline function.
+//
+// All output goes to qCDebug(lcCsdInstrumentation). The category defaults to
+// QtInfoMsg, so nothing is printed unless debug output is enabled, e.g. with
+// QT_LOGGING_RULES="csd.instrumentation.debug=true". The process-wide
+// counters are logged from a post routine, which only runs when the
+// QApplication is destroyed.
+namespace CSD::Instrumentation {
+
+#ifdef CSD_INSTRUMENTATION
+constexpr bool enabled = true;
+#else
+constexpr bool enabled = false;
+#endif
+
+enum Counter : std::size_t {
+    TitleBarPaints,
+    TitleBarPaintNs,
+    ButtonPaints,
+    ButtonPaintNs,
+    GlyphLoads,
+    // Running animations are the difference of the two
+    HoverAnimationStarts,
+    HoverAnimationStops,
+    PalettePropagations,
+    FilterDispatches,
+    FilterDispatchNs,
+    XcbRoundTrips,
+    ClientMoveMotions,
+    ClientMoveConfigures,
+    ClientMoveLatencyNs,
+    CounterCount,
+};
+
+struct Counters {
+    std::array<quint64, CounterCount> values{};
+
+    quint64 operator[](Counter counter) const {
+        return this->values[counter];
+    }
+};
+
+const char *counterName(Counter counter);
+
+// Snapshot of the process-wide counters
+Counters globalCounters();
+void resetGlobalCounters();
+void addGlobal(Counter counter, qint64 value);
+
+void logCounters(const char *label, const Counters &counters);
+void logGlobalCounters();
+
+inline void count(Counter counter, qint64 value = 1) {
+    if constexpr (enabled) {
+        addGlobal(counter, value);
+    }
+}
+
+inline void count(Counters *local, Counter counter, qint64 value = 1) {
+    if constexpr (enabled) {
+        addGlobal(counter, value);
+        if (local != nullptr) {
+            local->values[counter] += static_cast<quint64>(value);
+        }
+    }
+}
+
+// Adds the elapsed nanoseconds to a time counter on destruction
+class ScopedTimer {
+public:
+    ScopedTimer(Counters *local, Counter counter)
+        : m_local(local), m_counter(counter) {
+        if constexpr (enabled) {
+            this->m_timer.start();
+        }
+    }
+    ~ScopedTimer() {
+        if constexpr (enabled) {
+            count(this->m_local, this->m_counter, this->m_timer.nsecsElapsed());
+        }
+    }
+    ScopedTimer(const ScopedTimer &) = delete;
+    ScopedTimer &operator=(const ScopedTimer &) = delete;
+
+private:
+    Counters *m_local;
+    Counter m_counter;
+    QElapsedTimer m_timer;
+};
+
+// Chrome trace format timeline. Spans are recorded only when the
+// instrumentation is compiled in and CSD_TRACE_FILE names the JSON file to
+// write on exit, which can be opened in chrome://tracing or Perfetto.
+bool traceEnabled();
+qint64 traceClockNs();
+void addTraceEvent(const char *name, qint64 startNs, qint64 durationNs);
+
+class TraceSpan {
+public:
+    // A null name records nothing
+    explicit TraceSpan(const char *name) : m_name(name) {
+        if constexpr (enabled) {
+            if (this->m_name != nullptr && traceEnabled()) {
+                this->m_startNs = traceClockNs();
+            } else {
+                this->m_name = nullptr;
+            }
+        }
+    }
+    ~TraceSpan() {
+        if constexpr (enabled) {
+            if (this->m_name != nullptr) {
+                addTraceEvent(this->m_name,
+                              this->m_startNs,
+                              traceClockNs() - this->m_startNs);
+            }
+        }
+    }
+    TraceSpan(const TraceSpan &) = delete;
+    TraceSpan &operator=(const TraceSpan &) = delete;
+
+private:
+    const char *m_name;
+    qint64 m_startNs = 0;
+};
+
+} // namespace CSD::Instrumentation
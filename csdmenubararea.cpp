@@ -0,0 +1,182 @@
+#include "csdmenubararea.h"
+
+#include <QAction>
+#include <QEvent>
+#include <QMenuBar>
+#include <QStyle>
+
+#include <algorithm>
+#include <iterator>
+
+namespace CSD::Internal {
+
+MenuBarArea::MenuBarArea(QMenuBar *menuBar, QWidget *parent)
+    : QWidget(parent), m_menuBar(menuBar) {
+    this->setObjectName("MenuBarArea");
+    this->setSizePolicy(QSizePolicy::Preferred, QSizePolicy::Preferred);
+    this->m_menuBar->setParent(this);
+    this->m_menuBar->installEventFilter(this);
+    this->m_menuBar->show();
+}
+
+QMenuBar *MenuBarArea::menuBar() const {
+    return this->m_menuBar;
+}
+
+int MenuBarArea::visibleMenuCount() const {
+    return this->m_visibleMenus;
+}
+
+QSize MenuBarArea::sizeHint() const {
+    this->measure();
+    return this->m_naturalSize;
+}
+
+QSize MenuBarArea::minimumSizeHint() const {
+    this->measure();
+    return QSize(this->m_hasMenus ? this->m_extensionWidth : 0,
+                 this->m_naturalSize.height());
+}
+
+void MenuBarArea::invalidate() {
+    this->m_measured = false;
+    this->m_menusMeasured = false;
+    this->m_visibleMenus = -1;
+    this->updateGeometry();
+    if (this->m_fitPending) {
+        return;
+    }
+    // The filter sees the event before the menu bar has handled it
+    this->m_fitPending = true;
+    QMetaObject::invokeMethod(
+        this,
+        [this]() {
+            this->m_fitPending = false;
+            this->fit();
+        },
+        Qt::QueuedConnection);
+}
+
+void MenuBarArea::measure() const {
+    if (this->m_measured) {
+        return;
+    }
+    this->m_measured = true;
+
+    const QMenuBar *menuBar = this->m_menuBar;
+    this->m_naturalSize = menuBar->sizeHint()
+                              .expandedTo(menuBar->minimumSize())
+                              .boundedTo(menuBar->maximumSize());
+    this->m_extensionWidth =
+        menuBar->style()->pixelMetric(QStyle::PM_ToolBarExtensionExtent,
+                                      nullptr,
+                                      menuBar);
+    if (menuBar->isNativeMenuBar()) {
+        this->m_naturalSize.setWidth(0);
+        this->m_hasMenus = false;
+        return;
+    }
+    const auto actions = menuBar->actions();
+    this->m_hasMenus = std::any_of(
+        std::begin(actions), std::end(actions), [](QAction *action) {
+            return action->isVisible() && !action->isSeparator();
+        });
+}
+
+void MenuBarArea::measureMenus() {
+    this->measure();
+    if (this->m_menusMeasured) {
+        return;
+    }
+    this->m_menusMeasured = true;
+    this->m_menuExtents.clear();
+    this->m_trailingMargin = 0;
+    QMenuBar *menuBar = this->m_menuBar;
+    if (menuBar->isNativeMenuBar()) {
+        return;
+    }
+
+    // Lay the menu bar out once at its natural width to read every menu's
+    // position, later resizes only consult the cached extents. fit() sets
+    // the final geometry right after.
+    menuBar->resize(this->m_naturalSize);
+    const bool rightToLeft = menuBar->layoutDirection() == Qt::RightToLeft;
+    const int naturalWidth = this->m_naturalSize.width();
+    for (QAction *action : menuBar->actions()) {
+        const auto rect = menuBar->actionGeometry(action);
+        if (!action->isVisible() || rect.isEmpty()) {
+            continue;
+        }
+        this->m_menuExtents.push_back(
+            rightToLeft ? naturalWidth - rect.left() : rect.right() + 1);
+    }
+    this->m_trailingMargin =
+        this->m_menuExtents.empty()
+            ? 0
+            : std::max(0, naturalWidth - this->m_menuExtents.back());
+}
+
+void MenuBarArea::fit() {
+    this->measureMenus();
+    const auto size = this->size();
+    const int menuCount = static_cast<int>(this->m_menuExtents.size());
+    int visibleMenus = menuCount;
+    if (size.width() < this->m_naturalSize.width()) {
+        const int available =
+            size.width() - this->m_extensionWidth - this->m_trailingMargin;
+        visibleMenus = static_cast<int>(
+            std::upper_bound(std::begin(this->m_menuExtents),
+                             std::end(this->m_menuExtents),
+                             available) -
+            std::begin(this->m_menuExtents));
+    }
+    if (visibleMenus == this->m_visibleMenus && size == this->m_fittedSize) {
+        return;
+    }
+    this->m_visibleMenus = visibleMenus;
+    this->m_fittedSize = size;
+
+    int menuBarWidth = this->m_naturalSize.width();
+    if (visibleMenus < menuCount) {
+        const int leading =
+            visibleMenus > 0
+                ? this->m_menuExtents[static_cast<std::size_t>(
+                      visibleMenus - 1)]
+                : 0;
+        menuBarWidth = std::min(size.width(),
+                                leading + this->m_trailingMargin +
+                                    this->m_extensionWidth);
+    }
+    const int menuBarHeight =
+        std::min(size.height(), this->m_menuBar->maximumHeight());
+    const int x = this->layoutDirection() == Qt::RightToLeft
+                      ? size.width() - menuBarWidth
+                      : 0;
+    this->m_menuBar->setGeometry(x, 0, menuBarWidth, menuBarHeight);
+}
+
+void MenuBarArea::resizeEvent(QResizeEvent *event) {
+    QWidget::resizeEvent(event);
+    this->fit();
+}
+
+bool MenuBarArea::eventFilter(QObject *watched, QEvent *event) {
+    if (watched == this->m_menuBar) {
+        switch (event->type()) {
+        case QEvent::ActionAdded:
+        case QEvent::ActionChanged:
+        case QEvent::ActionRemoved:
+        case QEvent::FontChange:
+        case QEvent::StyleChange:
+        case QEvent::LanguageChange:
+        case QEvent::LayoutDirectionChange:
+            this->invalidate();
+            break;
+        default:
+            break;
+        }
+    }
+    return QWidget::eventFilter(watched, event);
+}
+
+} // namespace CSD::Internal
@@ -0,0 +1,54 @@
+#pragma once
+
+#include <QWidget>
+
+#include <vector>
+
+class QMenuBar;
+
+namespace CSD::Internal {
+
+// Hosts the main window's menu bar inside the TitleBar. The width each menu
+// needs is measured once and cached, so a resize only looks up how many
+// menus fit and touches the menu bar when that number changes. Menus that
+// do not fit collapse into the menu bar's extension button instead of being
+// clipped.
+class MenuBarArea final : public QWidget {
+    Q_OBJECT
+
+public:
+    explicit MenuBarArea(QMenuBar *menuBar, QWidget *parent = nullptr);
+
+    QMenuBar *menuBar() const;
+    int visibleMenuCount() const;
+
+    QSize sizeHint() const override;
+    QSize minimumSizeHint() const override;
+
+protected:
+    void resizeEvent(QResizeEvent *event) override;
+    bool eventFilter(QObject *watched, QEvent *event) override;
+
+private:
+    void invalidate();
+    // Reads the menu bar's size hints without touching its geometry
+    void measure() const;
+    void measureMenus();
+    void fit();
+
+    QMenuBar *m_menuBar;
+    mutable QSize m_naturalSize;
+    mutable int m_extensionWidth = 0;
+    mutable bool m_hasMenus = false;
+    mutable bool m_measured = false;
+    // Width from the leading edge of the menu bar to the trailing edge of
+    // each visible menu, in order
+    std::vector<int> m_menuExtents;
+    int m_trailingMargin = 0;
+    bool m_menusMeasured = false;
+    int m_visibleMenus = -1;
+    bool m_fitPending = false;
+    QSize m_fittedSize;
+};
+
+} // namespace CSD::Internal
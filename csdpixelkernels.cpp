@@ -0,0 +1,247 @@
+#include "csdpixelkernels.h"
+
+#include <private/qsimd_p.h>
+
+namespace CSD::Internal {
+
+constexpr static quint32 alphaBits = 0xff000000U;
+constexpr static quint32 redBits = 0x00ff0000U;
+
+// x * y / 255, rounded, for 8-bit channels
+static inline quint32 byteMul(quint32 x, quint32 y) {
+    const quint32 t = x * y + 0x80U;
+    return (t + (t >> 8)) >> 8;
+}
+
+static void
+tintScalar(quint32 *dst, const quint32 *mask, std::size_t count, QRgb color) {
+    for (std::size_t i = 0; i < count; ++i) {
+        const quint32 alpha = mask[i] >> 24;
+        quint32 pixel = 0;
+        for (int shift = 0; shift < 32; shift += 8) {
+            pixel |= byteMul(alpha, (color >> shift) & 0xffU) << shift;
+        }
+        dst[i] = pixel;
+    }
+}
+
+static bool anyAlphaScalar(const quint32 *pixels, std::size_t count) {
+    for (std::size_t i = 0; i < count; ++i) {
+        if ((pixels[i] & alphaBits) != 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+static void applyIconMaskScalar(quint32 *pixels,
+                                const quint32 *mask,
+                                std::size_t count) {
+    for (std::size_t i = 0; i < count; ++i) {
+        const bool masked = mask != nullptr && (mask[i] & redBits) != 0;
+        pixels[i] = masked ? 0U : pixels[i] | alphaBits;
+    }
+}
+
+#ifdef __SSE2__
+// Multiplies two vectors of 16-bit lanes holding 8-bit values, / 255
+static inline __m128i byteMulSse2(__m128i x, __m128i y) {
+    const __m128i t =
+        _mm_add_epi16(_mm_mullo_epi16(x, y), _mm_set1_epi16(0x80));
+    return _mm_srli_epi16(_mm_add_epi16(t, _mm_srli_epi16(t, 8)), 8);
+}
+
+static void
+tintSse2(quint32 *dst, const quint32 *mask, std::size_t count, QRgb color) {
+    const __m128i zero = _mm_setzero_si128();
+    // Two pixels of color with one channel per 16-bit lane
+    const __m128i color16 =
+        _mm_unpacklo_epi8(_mm_set1_epi32(static_cast<int>(color)), zero);
+    std::size_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        const __m128i pixels =
+            _mm_loadu_si128(reinterpret_cast<const __m128i *>(mask + i));
+        // Each pixel's alpha in all four of its 16-bit lanes
+        __m128i alpha = _mm_srli_epi32(pixels, 24);
+        alpha = _mm_or_si128(alpha, _mm_slli_epi32(alpha, 16));
+        const __m128i low =
+            byteMulSse2(_mm_unpacklo_epi32(alpha, alpha), color16);
+        const __m128i high =
+            byteMulSse2(_mm_unpackhi_epi32(alpha, alpha), color16);
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(dst + i),
+                         _mm_packus_epi16(low, high));
+    }
+    tintScalar(dst + i, mask + i, count - i, color);
+}
+
+static bool anyAlphaSse2(const quint32 *pixels, std::size_t count) {
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i alphaMask = _mm_set1_epi32(static_cast<int>(alphaBits));
+    std::size_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        const __m128i alpha = _mm_and_si128(
+            _mm_loadu_si128(reinterpret_cast<const __m128i *>(pixels + i)),
+            alphaMask);
+        if (_mm_movemask_epi8(_mm_cmpeq_epi32(alpha, zero)) != 0xffff) {
+            return true;
+        }
+    }
+    return anyAlphaScalar(pixels + i, count - i);
+}
+
+static void
+applyIconMaskSse2(quint32 *pixels, const quint32 *mask, std::size_t count) {
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i alphaMask = _mm_set1_epi32(static_cast<int>(alphaBits));
+    const __m128i redMask = _mm_set1_epi32(static_cast<int>(redBits));
+    std::size_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        auto *p = reinterpret_cast<__m128i *>(pixels + i);
+        __m128i result = _mm_or_si128(_mm_loadu_si128(p), alphaMask);
+        if (mask != nullptr) {
+            const __m128i red = _mm_and_si128(
+                _mm_loadu_si128(reinterpret_cast<const __m128i *>(mask + i)),
+                redMask);
+            result = _mm_and_si128(result, _mm_cmpeq_epi32(red, zero));
+        }
+        _mm_storeu_si128(p, result);
+    }
+    applyIconMaskScalar(
+        pixels + i, mask != nullptr ? mask + i : nullptr, count - i);
+}
+#endif
+
+#if QT_COMPILER_SUPPORTS_HERE(AVX2)
+QT_FUNCTION_TARGET(AVX2)
+static inline __m256i byteMulAvx2(__m256i x, __m256i y) {
+    const __m256i t =
+        _mm256_add_epi16(_mm256_mullo_epi16(x, y), _mm256_set1_epi16(0x80));
+    return _mm256_srli_epi16(_mm256_add_epi16(t, _mm256_srli_epi16(t, 8)), 8);
+}
+
+// Unpacking and packing work within each 128-bit lane, so pixel order is
+// preserved just like in the SSE2 version
+QT_FUNCTION_TARGET(AVX2)
+static void
+tintAvx2(quint32 *dst, const quint32 *mask, std::size_t count, QRgb color) {
+    const __m256i zero = _mm256_setzero_si256();
+    const __m256i color16 = _mm256_unpacklo_epi8(
+        _mm256_set1_epi32(static_cast<int>(color)), zero);
+    std::size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        const __m256i pixels =
+            _mm256_loadu_si256(reinterpret_cast<const __m256i *>(mask + i));
+        __m256i alpha = _mm256_srli_epi32(pixels, 24);
+        alpha = _mm256_or_si256(alpha, _mm256_slli_epi32(alpha, 16));
+        const __m256i low =
+            byteMulAvx2(_mm256_unpacklo_epi32(alpha, alpha), color16);
+        const __m256i high =
+            byteMulAvx2(_mm256_unpackhi_epi32(alpha, alpha), color16);
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(dst + i),
+                            _mm256_packus_epi16(low, high));
+    }
+    tintScalar(dst + i, mask + i, count - i, color);
+}
+
+QT_FUNCTION_TARGET(AVX2)
+static bool anyAlphaAvx2(const quint32 *pixels, std::size_t count) {
+    const __m256i alphaMask = _mm256_set1_epi32(static_cast<int>(alphaBits));
+    std::size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        const __m256i chunk =
+            _mm256_loadu_si256(reinterpret_cast<const __m256i *>(pixels + i));
+        if (!_mm256_testz_si256(chunk, alphaMask)) {
+            return true;
+        }
+    }
+    return anyAlphaScalar(pixels + i, count - i);
+}
+
+QT_FUNCTION_TARGET(AVX2)
+static void
+applyIconMaskAvx2(quint32 *pixels, const quint32 *mask, std::size_t count) {
+    const __m256i zero = _mm256_setzero_si256();
+    const __m256i alphaMask = _mm256_set1_epi32(static_cast<int>(alphaBits));
+    const __m256i redMask = _mm256_set1_epi32(static_cast<int>(redBits));
+    std::size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        auto *p = reinterpret_cast<__m256i *>(pixels + i);
+        __m256i result = _mm256_or_si256(_mm256_loadu_si256(p), alphaMask);
+        if (mask != nullptr) {
+            const __m256i red = _mm256_and_si256(
+                _mm256_loadu_si256(
+                    reinterpret_cast<const __m256i *>(mask + i)),
+                redMask);
+            result =
+                _mm256_and_si256(result, _mm256_cmpeq_epi32(red, zero));
+        }
+        _mm256_storeu_si256(p, result);
+    }
+    applyIconMaskScalar(
+        pixels + i, mask != nullptr ? mask + i : nullptr, count - i);
+}
+#endif
+
+void tintPixels(quint32 *dst,
+                const quint32 *mask,
+                std::size_t count,
+                QRgb color) {
+    const QRgb premultiplied = qPremultiply(color);
+#if QT_COMPILER_SUPPORTS_HERE(AVX2)
+    if (qCpuHasFeature(AVX2)) {
+        tintAvx2(dst, mask, count, premultiplied);
+        return;
+    }
+#endif
+#ifdef __SSE2__
+    tintSse2(dst, mask, count, premultiplied);
+#else
+    tintScalar(dst, mask, count, premultiplied);
+#endif
+}
+
+bool anyAlpha(const quint32 *pixels, std::size_t count) {
+#if QT_COMPILER_SUPPORTS_HERE(AVX2)
+    if (qCpuHasFeature(AVX2)) {
+        return anyAlphaAvx2(pixels, count);
+    }
+#endif
+#ifdef __SSE2__
+    return anyAlphaSse2(pixels, count);
+#else
+    return anyAlphaScalar(pixels, count);
+#endif
+}
+
+void applyIconMask(quint32 *pixels, const quint32 *mask, std::size_t count) {
+#if QT_COMPILER_SUPPORTS_HERE(AVX2)
+    if (qCpuHasFeature(AVX2)) {
+        applyIconMaskAvx2(pixels, mask, count);
+        return;
+    }
+#endif
+#ifdef __SSE2__
+    applyIconMaskSse2(pixels, mask, count);
+#else
+    applyIconMaskScalar(pixels, mask, count);
+#endif
+}
+
+QImage tintImage(const QImage &mask, const QColor &color) {
+    if (mask.isNull()) {
+        return QImage();
+    }
+    auto source = mask.convertToFormat(QImage::Format_ARGB32_Premultiplied);
+    auto tinted = QImage(source.size(), QImage::Format_ARGB32_Premultiplied);
+    tinted.setDevicePixelRatio(mask.devicePixelRatio());
+    const auto width = static_cast<std::size_t>(source.width());
+    for (int y = 0; y < source.height(); ++y) {
+        tintPixels(reinterpret_cast<quint32 *>(tinted.scanLine(y)),
+                   reinterpret_cast<const quint32 *>(source.constScanLine(y)),
+                   width,
+                   color.rgba());
+    }
+    return tinted;
+}
+
+} // namespace CSD::Internal
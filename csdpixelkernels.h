@@ -0,0 +1,32 @@
+#pragma once
+
+#include <QColor>
+#include <QImage>
+#include <QtGlobal>
+
+#include <cstddef>
+
+// Loops over 32-bit ARGB pixels, vectorized with AVX2 or SSE2 when the CPU
+// has them and scalar otherwise. Each picks its implementation at runtime.
+namespace CSD::Internal {
+
+// Writes color, premultiplied and scaled by the alpha of each mask pixel,
+// to dst as ARGB32_Premultiplied. dst may be the mask itself.
+void tintPixels(quint32 *dst,
+                const quint32 *mask,
+                std::size_t count,
+                QRgb color);
+
+// Whether any pixel has a non-zero alpha
+bool anyAlpha(const quint32 *pixels, std::size_t count);
+
+// Makes pixels opaque, except where the red channel of the AND mask of a
+// Windows icon is set, which become transparent. A null mask only makes
+// every pixel opaque.
+void applyIconMask(quint32 *pixels, const quint32 *mask, std::size_t count);
+
+// Copy of a glyph mask with every pixel set to color and the mask's alpha,
+// keeping the device pixel ratio
+QImage tintImage(const QImage &mask, const QColor &color);
+
+} // namespace CSD::Internal
@@ -0,0 +1,647 @@
+#include "csdquicktitlebar.h"
+
+#include "csdglyphatlas.h"
+#include "csdglyphcache.h"
+#include "csdglyphraster.h"
+#include "csdpixelkernels.h"
+#include "csdthemewatcher.h"
+#include "csdtitlebar.h"
+
+#if !defined(_WIN32) && !defined(__APPLE__)
+#include "linuxclientmove.h"
+#include "linuxxcb.h"
+#endif
+
+#include <QApplication>
+#include <QGuiApplication>
+#include <QHash>
+#include <QHoverEvent>
+#include <QMouseEvent>
+#include <QQmlEngine>
+#include <QQuickWindow>
+#include <QSGImageNode>
+#include <QSGNode>
+#include <QSGRectangleNode>
+#include <QSGTexture>
+
+#include <array>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+
+#if !defined(_WIN32) && !defined(__APPLE__)
+#include <QX11Info>
+
+#include <private/qhighdpiscaling_p.h>
+#endif
+
+namespace CSD {
+
+namespace {
+
+constexpr std::array<TitleBarButton::Role, 3> captionButtons = {
+    TitleBarButton::Minimize,
+    TitleBarButton::MaximizeRestore,
+    TitleBarButton::Close,
+};
+
+// Glyph textures of one window, shared by all title bars in it. They are
+// created and deleted on the window's render thread.
+class GlyphTextures {
+public:
+    explicit GlyphTextures(QQuickWindow *window) : m_window(window) {}
+    ~GlyphTextures() {
+        delete this->m_atlas;
+        qDeleteAll(this->m_glyphs);
+    }
+    GlyphTextures(const GlyphTextures &) = delete;
+    GlyphTextures &operator=(const GlyphTextures &) = delete;
+
+    QSGTexture *atlas() {
+        if (this->m_atlas == nullptr && !Internal::glyphAtlas().isNull()) {
+            this->m_atlas =
+                this->m_window->createTextureFromImage(Internal::glyphAtlas());
+        }
+        return this->m_atlas;
+    }
+
+    // Glyphs not drawn straight from the atlas, built without going through
+    // QPixmap so that this is safe on the render thread. Tinted glyphs start
+    // from the atlas copy of their mask when there is one.
+    QSGTexture *glyph(const Internal::GlyphKey &key) {
+        auto it = this->m_glyphs.find(key);
+        if (it != std::end(this->m_glyphs)) {
+            return it.value();
+        }
+        const qreal devicePixelRatio = key.dprPercent / 100.0;
+        const auto atlasRect =
+            key.tint != 0 ? Internal::glyphAtlasRect(key.style,
+                                                     key.role,
+                                                     key.active,
+                                                     key.maximized,
+                                                     key.hovered,
+                                                     key.pressed,
+                                                     devicePixelRatio,
+                                                     key.iconSize)
+                          : QRect();
+        auto image = QImage();
+        if (!atlasRect.isNull()) {
+            image = Internal::glyphAtlas().copy(atlasRect);
+        } else {
+            const auto paths =
+                Internal::captionIconPathsForState(key.active,
+                                                   key.maximized,
+                                                   key.hovered,
+                                                   key.pressed,
+                                                   key.style);
+            image = Internal::rasterizeGlyphImage(
+                paths[key.role - TitleBarButton::Minimize].toString(),
+                devicePixelRatio,
+                key.iconSize);
+        }
+        if (key.tint != 0) {
+            image = Internal::tintImage(image, QColor::fromRgba(key.tint));
+        }
+        QSGTexture *texture =
+            image.isNull() ? nullptr
+                           : this->m_window->createTextureFromImage(
+                                 image, QQuickWindow::TextureCanUseAtlas);
+        this->m_glyphs.insert(key, texture);
+        return texture;
+    }
+
+private:
+    QQuickWindow *m_window;
+    QSGTexture *m_atlas = nullptr;
+    QHash<Internal::GlyphKey, QSGTexture *> m_glyphs;
+};
+
+std::mutex glyphTexturesMutex;
+
+// A window keeps its entry while its scene graph is rebuilt, only the
+// textures are dropped, so its signals are connected once
+std::unordered_map<QQuickWindow *, std::unique_ptr<GlyphTextures>> &
+glyphTexturesByWindow() {
+    static std::unordered_map<QQuickWindow *, std::unique_ptr<GlyphTextures>>
+        textures;
+    return textures;
+}
+
+void dropGlyphTextures(QQuickWindow *window) {
+    const auto lock = std::lock_guard<std::mutex>(glyphTexturesMutex);
+    auto &textures = glyphTexturesByWindow();
+    auto it = textures.find(window);
+    if (it != std::end(textures)) {
+        it->second.reset();
+    }
+}
+
+void forgetGlyphTextures(QQuickWindow *window) {
+    const auto lock = std::lock_guard<std::mutex>(glyphTexturesMutex);
+    glyphTexturesByWindow().erase(window);
+}
+
+GlyphTextures &glyphTextures(QQuickWindow *window) {
+    const auto lock = std::lock_guard<std::mutex>(glyphTexturesMutex);
+    auto &textures = glyphTexturesByWindow();
+    auto it = textures.find(window);
+    if (it == std::end(textures)) {
+        it = textures.emplace(window, nullptr).first;
+        // Invalidation is emitted on the render thread, which also has to
+        // delete the textures
+        QObject::connect(
+            window,
+            &QQuickWindow::sceneGraphInvalidated,
+            window,
+            [window]() { dropGlyphTextures(window); },
+            Qt::DirectConnection);
+        QObject::connect(window, &QObject::destroyed, window, [window]() {
+            forgetGlyphTextures(window);
+        });
+    }
+    if (!it->second) {
+        it->second = std::make_unique<GlyphTextures>(window);
+    }
+    return *it->second;
+}
+
+class TitleBarNode final : public QSGNode {
+public:
+    ~TitleBarNode() override {
+        delete this->captionIconTexture;
+    }
+
+    QSGRectangleNode *background = nullptr;
+    QSGImageNode *captionIcon = nullptr;
+    QSGTexture *captionIconTexture = nullptr;
+    quint64 captionIconSerial = 0;
+    std::array<QSGRectangleNode *, 3> hoverFills{};
+    std::array<QSGImageNode *, 3> glyphs{};
+};
+
+// Image nodes must not be rendered without a texture, so they only exist
+// while they have one
+void updateImageNode(QQuickWindow *window,
+                     QSGNode *parent,
+                     QSGNode *after,
+                     QSGImageNode *&node,
+                     QSGTexture *texture,
+                     const QRectF &rect,
+                     const QRectF &sourceRect) {
+    if (texture == nullptr || rect.isEmpty()) {
+        if (node != nullptr) {
+            parent->removeChildNode(node);
+            delete node;
+            node = nullptr;
+        }
+        return;
+    }
+    if (node == nullptr) {
+        node = window->createImageNode();
+        node->setFiltering(QSGTexture::Linear);
+        parent->insertChildNodeAfter(node, after);
+    }
+    node->setTexture(texture);
+    node->setRect(rect);
+    node->setSourceRect(sourceRect);
+}
+
+QRectF centeredRect(const QSizeF &size, const QRectF &bounds) {
+    auto rect = QRectF(QPointF(0, 0), size);
+    rect.moveCenter(bounds.center());
+    return rect;
+}
+
+Internal::StyleMetrics quickStyleMetrics(qreal devicePixelRatio) {
+    if (qobject_cast<QApplication *>(QCoreApplication::instance()) !=
+        nullptr) {
+        return Internal::styleMetrics(QApplication::style(), devicePixelRatio);
+    }
+    // Without widgets there is no style to ask
+    auto metrics = Internal::StyleMetrics();
+    metrics.titleBarHeight = 24;
+    metrics.buttonSize = 16;
+    metrics.buttonIconSize = 16;
+    metrics.captionIconSize = 16;
+    metrics.horizontalSpacing = 6;
+    return metrics;
+}
+
+} // namespace
+
+QuickTitleBar::QuickTitleBar(QQuickItem *parent)
+    : QQuickItem(parent),
+      m_activeColor(Internal::ThemeWatcher::instance().accentColor()) {
+    this->setFlag(QQuickItem::ItemHasContents);
+    this->setAcceptHoverEvents(true);
+    this->setAcceptedMouseButtons(Qt::LeftButton);
+    this->relayout();
+}
+
+QuickTitleBar::~QuickTitleBar() = default;
+
+void QuickTitleBar::registerType() {
+    qmlRegisterType<QuickTitleBar>("CSD", 1, 0, "TitleBar");
+}
+
+bool QuickTitleBar::isActive() const {
+    return this->m_active;
+}
+
+void QuickTitleBar::setActive(bool active) {
+    if (active == this->m_active) {
+        return;
+    }
+    this->m_active = active;
+    this->update();
+    emit this->activeChanged();
+}
+
+bool QuickTitleBar::isMaximized() const {
+    return this->m_maximized;
+}
+
+void QuickTitleBar::setMaximized(bool maximized) {
+    if (maximized == this->m_maximized) {
+        return;
+    }
+    this->m_maximized = maximized;
+    this->update();
+    emit this->maximizedChanged();
+}
+
+bool QuickTitleBar::isMinimizable() const {
+    return this->m_minimizable;
+}
+
+void QuickTitleBar::setMinimizable(bool on) {
+    if (on == this->m_minimizable) {
+        return;
+    }
+    this->m_minimizable = on;
+    this->relayout();
+    emit this->minimizableChanged();
+}
+
+bool QuickTitleBar::isMaximizable() const {
+    return this->m_maximizable;
+}
+
+void QuickTitleBar::setMaximizable(bool on) {
+    if (on == this->m_maximizable) {
+        return;
+    }
+    this->m_maximizable = on;
+    this->relayout();
+    emit this->maximizableChanged();
+}
+
+int QuickTitleBar::captionButtonStyle() const {
+    return static_cast<int>(this->m_captionButtonStyle);
+}
+
+void QuickTitleBar::setCaptionButtonStyle(int captionButtonStyle) {
+    // The style indexes the caption state table and the glyph atlas
+    if (captionButtonStyle < static_cast<int>(CaptionButtonStyle::custom) ||
+        captionButtonStyle > static_cast<int>(CaptionButtonStyle::mac)) {
+        qWarning("QuickTitleBar: ignoring unknown captionButtonStyle %d",
+                 captionButtonStyle);
+        return;
+    }
+    const auto style = static_cast<CaptionButtonStyle>(captionButtonStyle);
+    if (style == this->m_captionButtonStyle) {
+        return;
+    }
+    this->m_captionButtonStyle = style;
+    this->update();
+    emit this->captionButtonStyleChanged();
+}
+
+QColor QuickTitleBar::activeColor() const {
+    return this->m_activeColor;
+}
+
+void QuickTitleBar::setActiveColor(const QColor &activeColor) {
+    if (activeColor == this->m_activeColor) {
+        return;
+    }
+    this->m_activeColor = activeColor;
+    this->update();
+    emit this->activeColorChanged();
+}
+
+QColor QuickTitleBar::inactiveColor() const {
+    return this->m_inactiveColor;
+}
+
+void QuickTitleBar::setInactiveColor(const QColor &inactiveColor) {
+    if (inactiveColor == this->m_inactiveColor) {
+        return;
+    }
+    this->m_inactiveColor = inactiveColor;
+    this->update();
+    emit this->inactiveColorChanged();
+}
+
+QColor QuickTitleBar::hoverColor() const {
+    return this->m_hoverColor;
+}
+
+void QuickTitleBar::setHoverColor(const QColor &hoverColor) {
+    if (hoverColor == this->m_hoverColor) {
+        return;
+    }
+    this->m_hoverColor = hoverColor;
+    this->update();
+    emit this->hoverColorChanged();
+}
+
+bool QuickTitleBar::isDragArea(const QPointF &pos) const {
+    if (!this->contains(pos)) {
+        return false;
+    }
+    for (const auto &rect : this->m_captionLayout.parts) {
+        if (rect.contains(pos.toPoint())) {
+            return false;
+        }
+    }
+    return true;
+}
+
+qreal QuickTitleBar::devicePixelRatio() const {
+    const QQuickWindow *window = this->window();
+    return window != nullptr ? window->effectiveDevicePixelRatio()
+                             : qApp->devicePixelRatio();
+}
+
+void QuickTitleBar::relayout() {
+    const auto metrics = quickStyleMetrics(this->devicePixelRatio());
+    if (metrics != this->m_styleMetrics) {
+        this->m_styleMetrics = metrics;
+        this->setImplicitHeight(metrics.titleBarHeight);
+        this->refreshCaptionIcon();
+    }
+    this->m_captionLayout =
+        Internal::layoutCaption(this->size().toSize(),
+                                this->m_styleMetrics,
+                                Internal::captionLeftMargin,
+                                this->m_minimizable,
+                                this->m_maximizable,
+                                QGuiApplication::layoutDirection());
+    this->update();
+}
+
+void QuickTitleBar::refreshCaptionIcon() {
+    auto icon = QGuiApplication::windowIcon();
+    if (icon.isNull()) {
+        icon = Internal::fallbackCaptionIcon();
+    }
+    const int size = this->m_styleMetrics.captionIconSize;
+    this->m_captionIconImage =
+        icon.pixmap(QSize(size, size) * this->devicePixelRatio()).toImage();
+    ++this->m_captionIconSerial;
+    this->update();
+}
+
+void QuickTitleBar::geometryChanged(const QRectF &newGeometry,
+                                    const QRectF &oldGeometry) {
+    QQuickItem::geometryChanged(newGeometry, oldGeometry);
+    if (newGeometry.size() != oldGeometry.size()) {
+        this->relayout();
+    }
+}
+
+void QuickTitleBar::itemChange(ItemChange change,
+                               const ItemChangeData &value) {
+    QQuickItem::itemChange(change, value);
+    switch (change) {
+    case ItemSceneChange:
+    case ItemDevicePixelRatioHasChanged:
+        // Style metrics and the caption icon depend on the scale
+        this->m_styleMetrics = Internal::StyleMetrics();
+        this->relayout();
+        break;
+    case ItemEnabledHasChanged:
+        this->m_captionButtonStates.reset();
+        this->update();
+        break;
+    default:
+        break;
+    }
+}
+
+int QuickTitleBar::buttonAt(const QPointF &pos) const {
+    if (!this->isEnabled()) {
+        return Internal::CaptionButtonStates::none;
+    }
+    return Internal::CaptionButtonStates::buttonAt(this->m_captionLayout,
+                                                   pos.toPoint());
+}
+
+void QuickTitleBar::setHoveredButton(int role) {
+    if (this->m_captionButtonStates.setHovered(role)) {
+        this->update();
+    }
+}
+
+void QuickTitleBar::hoverMoveEvent(QHoverEvent *event) {
+    this->setHoveredButton(this->buttonAt(event->posF()));
+}
+
+void QuickTitleBar::hoverLeaveEvent([[maybe_unused]] QHoverEvent *event) {
+    this->setHoveredButton(Internal::CaptionButtonStates::none);
+}
+
+void QuickTitleBar::mousePressEvent(QMouseEvent *event) {
+    const int role = this->buttonAt(event->localPos());
+    if (this->m_captionButtonStates.press(role)) {
+        this->update();
+        return;
+    }
+#if !defined(_WIN32) && !defined(__APPLE__)
+    QQuickWindow *window = this->window();
+    if (QX11Info::isPlatformX11() && window != nullptr &&
+        this->isDragArea(event->localPos())) {
+        const QPoint globalPos =
+            QHighDpi::toNativePixels(event->globalPos(), window->screen());
+        const int screenNumber = Internal::xcbScreenNumber(window->screen());
+        auto &connectionCache = Internal::XcbConnectionCache::forConnection(
+            QX11Info::connection());
+        if (connectionCache.isMoveResizeSupported(screenNumber)) {
+            connectionCache.startMoveResize(
+                static_cast<xcb_window_t>(window->winId()),
+                screenNumber,
+                globalPos.x(),
+                globalPos.y(),
+                Internal::XcbConnectionCache::Move);
+        } else {
+            if (this->m_clientMove == nullptr) {
+                this->m_clientMove =
+                    new Internal::ClientMove(&this->m_counters, this);
+            }
+            this->m_clientMove->start(window, globalPos);
+        }
+        return;
+    }
+#endif
+    event->ignore();
+}
+
+void QuickTitleBar::mouseMoveEvent(QMouseEvent *event) {
+#if !defined(_WIN32) && !defined(__APPLE__)
+    if (this->m_clientMove != nullptr && this->m_clientMove->isActive()) {
+        this->m_clientMove->update(QHighDpi::toNativePixels(
+            event->globalPos(), this->window()->screen()));
+        return;
+    }
+#endif
+    this->setHoveredButton(this->buttonAt(event->localPos()));
+}
+
+void QuickTitleBar::mouseReleaseEvent(QMouseEvent *event) {
+#if !defined(_WIN32) && !defined(__APPLE__)
+    if (this->m_clientMove != nullptr && this->m_clientMove->isActive()) {
+        this->m_clientMove->finish();
+        return;
+    }
+#endif
+    const int clicked = this->m_captionButtonStates.release(
+        this->buttonAt(event->localPos()));
+    this->update();
+    switch (clicked) {
+    case TitleBarButton::Minimize:
+        emit this->minimizeClicked();
+        break;
+    case TitleBarButton::MaximizeRestore:
+        emit this->maximizeRestoreClicked();
+        break;
+    case TitleBarButton::Close:
+        emit this->closeClicked();
+        break;
+    default:
+        break;
+    }
+}
+
+void QuickTitleBar::mouseUngrabEvent() {
+#if !defined(_WIN32) && !defined(__APPLE__)
+    if (this->m_clientMove != nullptr && this->m_clientMove->isActive()) {
+        this->m_clientMove->finish();
+    }
+#endif
+    this->m_captionButtonStates.release(Internal::CaptionButtonStates::none);
+    this->update();
+}
+
+QSGNode *QuickTitleBar::updatePaintNode(
+    QSGNode *oldNode, [[maybe_unused]] UpdatePaintNodeData *data) {
+    QQuickWindow *window = this->window();
+    auto *node = static_cast<TitleBarNode *>(oldNode);
+    if (node == nullptr) {
+        node = new TitleBarNode();
+        node->background = window->createRectangleNode();
+        node->appendChildNode(node->background);
+        for (auto &hoverFill : node->hoverFills) {
+            hoverFill = window->createRectangleNode();
+            node->appendChildNode(hoverFill);
+        }
+    }
+
+    node->background->setRect(this->boundingRect());
+    node->background->setColor(this->m_active ? this->m_activeColor
+                                              : this->m_inactiveColor);
+
+    const qreal dpr = window->effectiveDevicePixelRatio();
+    if (node->captionIconSerial != this->m_captionIconSerial) {
+        delete node->captionIconTexture;
+        node->captionIconTexture =
+            this->m_captionIconImage.isNull()
+                ? nullptr
+                : window->createTextureFromImage(this->m_captionIconImage);
+        node->captionIconSerial = this->m_captionIconSerial;
+    }
+    const int captionIconSize = this->m_styleMetrics.captionIconSize;
+    updateImageNode(
+        window,
+        node,
+        node->background,
+        node->captionIcon,
+        node->captionIconTexture,
+        centeredRect(QSizeF(captionIconSize, captionIconSize),
+                     this->m_captionLayout.parts[TitleBarButton::CaptionIcon]),
+        node->captionIconTexture != nullptr
+            ? QRectF(QPointF(0, 0), node->captionIconTexture->textureSize())
+            : QRectF());
+
+    auto &textures = glyphTextures(window);
+    const auto &states = this->m_captionButtonStates;
+    const auto style = this->m_captionButtonStyle;
+    const auto iconSize = QSize(this->m_styleMetrics.buttonIconSize,
+                                this->m_styleMetrics.buttonIconSize);
+    for (std::size_t i = 0; i < captionButtons.size(); ++i) {
+        const auto role = captionButtons[i];
+        const QRectF rect = this->m_captionLayout.parts[role];
+        const bool hovered =
+            this->isEnabled() && states.isHovered(role, style);
+        const bool pressed = hovered && states.isPressed(role);
+
+        // Like the widgets, mac style never fills the hovered button
+        const bool filled = hovered && style != CaptionButtonStyle::mac;
+        const auto hoverFill = role == TitleBarButton::Close
+                                   ? TitleBarButton::closeHoverColor()
+                                   : this->m_hoverColor;
+        node->hoverFills[i]->setRect(filled ? rect : QRectF());
+        node->hoverFills[i]->setColor(hoverFill);
+
+        // Tinted glyphs are keyed by color alone, not by state
+        const auto tint = Internal::captionGlyphTint(
+            style,
+            role,
+            this->m_active,
+            hovered,
+            this->m_active ? this->m_activeColor : this->m_inactiveColor,
+            hoverFill);
+        const bool tinted = tint.isValid();
+        QSGTexture *texture = nullptr;
+        auto sourceRect = QRectF();
+        const auto atlasRect =
+            tinted ? QRect()
+                   : Internal::glyphAtlasRect(style,
+                                              role,
+                                              this->m_active,
+                                              this->m_maximized,
+                                              hovered,
+                                              pressed,
+                                              dpr,
+                                              iconSize);
+        if (!atlasRect.isNull()) {
+            texture = textures.atlas();
+            sourceRect = atlasRect;
+        } else {
+            texture = textures.glyph(Internal::GlyphKey{
+                style,
+                role,
+                this->m_active && !tinted,
+                this->m_maximized &&
+                    (!tinted || role == TitleBarButton::MaximizeRestore),
+                hovered && !tinted,
+                pressed && !tinted,
+                Internal::dprToPercent(dpr),
+                iconSize,
+                tinted ? tint.rgba() : 0});
+            if (texture != nullptr) {
+                sourceRect = QRectF(QPointF(0, 0), texture->textureSize());
+            }
+        }
+        updateImageNode(window,
+                        node,
+                        node->hoverFills[i],
+                        node->glyphs[i],
+                        texture,
+                        centeredRect(sourceRect.size() / dpr, rect),
+                        sourceRect);
+    }
+    return node;
+}
+
+} // namespace CSD
@@ -0,0 +1,124 @@
+#pragma once
+
+#include "captionbuttonstyle.h"
+#include "csdcaptionbuttons.h"
+#include "csdinstrumentation.h"
+#include "csdstylemetrics.h"
+
+#include <QColor>
+#include <QImage>
+#include <QQuickItem>
+
+namespace CSD {
+
+namespace Internal {
+class ClientMove;
+}
+
+// Title bar item for QML windows. It shares the caption layout, the hover
+// and press state and the caption state table with the painted TitleBar and
+// renders through the scene graph, so it also runs on the software backend.
+// Glyphs come from textures shared by every title bar of a window: the baked
+// glyph atlas for untinted glyphs it covers, Qt Quick's texture atlas for
+// the rest.
+class QuickTitleBar : public QQuickItem {
+    Q_OBJECT
+    Q_PROPERTY(bool active READ isActive WRITE setActive NOTIFY activeChanged)
+    Q_PROPERTY(bool maximized READ isMaximized WRITE setMaximized NOTIFY
+                   maximizedChanged)
+    Q_PROPERTY(bool minimizable READ isMinimizable WRITE setMinimizable NOTIFY
+                   minimizableChanged)
+    Q_PROPERTY(bool maximizable READ isMaximizable WRITE setMaximizable NOTIFY
+                   maximizableChanged)
+    Q_PROPERTY(int captionButtonStyle READ captionButtonStyle WRITE
+                   setCaptionButtonStyle NOTIFY captionButtonStyleChanged)
+    Q_PROPERTY(QColor activeColor READ activeColor WRITE setActiveColor NOTIFY
+                   activeColorChanged)
+    Q_PROPERTY(QColor inactiveColor READ inactiveColor WRITE
+                   setInactiveColor NOTIFY inactiveColorChanged)
+    Q_PROPERTY(QColor hoverColor READ hoverColor WRITE setHoverColor NOTIFY
+                   hoverColorChanged)
+
+public:
+    explicit QuickTitleBar(QQuickItem *parent = nullptr);
+    ~QuickTitleBar() override;
+
+    // Makes the item available to QML as CSD.TitleBar 1.0
+    static void registerType();
+
+    bool isActive() const;
+    void setActive(bool active);
+    bool isMaximized() const;
+    void setMaximized(bool maximized);
+    bool isMinimizable() const;
+    void setMinimizable(bool on);
+    bool isMaximizable() const;
+    void setMaximizable(bool on);
+    int captionButtonStyle() const;
+    void setCaptionButtonStyle(int captionButtonStyle);
+    QColor activeColor() const;
+    void setActiveColor(const QColor &activeColor);
+    QColor inactiveColor() const;
+    void setInactiveColor(const QColor &inactiveColor);
+    QColor hoverColor() const;
+    void setHoverColor(const QColor &hoverColor);
+
+    Q_INVOKABLE bool isDragArea(const QPointF &pos) const;
+
+signals:
+    void activeChanged();
+    void maximizedChanged();
+    void minimizableChanged();
+    void maximizableChanged();
+    void captionButtonStyleChanged();
+    void activeColorChanged();
+    void inactiveColorChanged();
+    void hoverColorChanged();
+    void minimizeClicked();
+    void maximizeRestoreClicked();
+    void closeClicked();
+
+protected:
+    QSGNode *updatePaintNode(QSGNode *oldNode,
+                             UpdatePaintNodeData *data) override;
+    void geometryChanged(const QRectF &newGeometry,
+                         const QRectF &oldGeometry) override;
+    void itemChange(ItemChange change, const ItemChangeData &value) override;
+    void hoverMoveEvent(QHoverEvent *event) override;
+    void hoverLeaveEvent(QHoverEvent *event) override;
+    void mousePressEvent(QMouseEvent *event) override;
+    void mouseMoveEvent(QMouseEvent *event) override;
+    void mouseReleaseEvent(QMouseEvent *event) override;
+    void mouseUngrabEvent() override;
+
+private:
+    void relayout();
+    void refreshCaptionIcon();
+    void setHoveredButton(int role);
+    int buttonAt(const QPointF &pos) const;
+    qreal devicePixelRatio() const;
+
+    bool m_active = false;
+    bool m_maximized = false;
+    bool m_minimizable = true;
+    bool m_maximizable = true;
+    CaptionButtonStyle m_captionButtonStyle = CaptionButtonStyle::custom;
+    QColor m_activeColor;
+    QColor m_inactiveColor = Qt::white;
+    QColor m_hoverColor = Qt::gray;
+
+    Internal::StyleMetrics m_styleMetrics;
+    Internal::CaptionLayout m_captionLayout;
+    Internal::CaptionButtonStates m_captionButtonStates;
+
+    // Rasterized on the GUI thread, uploaded by the next sync
+    QImage m_captionIconImage;
+    quint64 m_captionIconSerial = 0;
+
+#if !defined(_WIN32) && !defined(__APPLE__)
+    Internal::ClientMove *m_clientMove = nullptr;
+#endif
+    Instrumentation::Counters m_counters;
+};
+
+} // namespace CSD
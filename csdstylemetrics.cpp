@@ -0,0 +1,117 @@
+#include "csdstylemetrics.h"
+
+#include "csdglyphraster.h"
+
+#ifdef _WIN32
+#include "qtwinbackports.h"
+
+#include <Windows.h>
+#endif
+
+#include <QApplication>
+#include <QStyle>
+#include <QTimer>
+
+#include <map>
+#include <set>
+#include <utility>
+
+namespace CSD::Internal {
+
+using StyleMetricsKey = std::pair<const QStyle *, int>;
+
+static std::map<StyleMetricsKey, StyleMetrics> &metricsCache() {
+    static std::map<StyleMetricsKey, StyleMetrics> cache;
+    return cache;
+}
+
+// Styles whose metrics were dropped during the current event loop pass
+static std::set<const QStyle *> &invalidatedStyles() {
+    static std::set<const QStyle *> styles;
+    return styles;
+}
+
+static void dropStyleMetrics(const QStyle *style) {
+    auto &cache = metricsCache();
+    auto it = cache.lower_bound(StyleMetricsKey(style, 0));
+    while (it != std::end(cache) && it->first.first == style) {
+        it = cache.erase(it);
+    }
+}
+
+bool StyleMetrics::operator==(const StyleMetrics &other) const {
+    return this->titleBarHeight == other.titleBarHeight &&
+           this->buttonSize == other.buttonSize &&
+           this->buttonIconSize == other.buttonIconSize &&
+           this->captionIconSize == other.captionIconSize &&
+           this->horizontalSpacing == other.horizontalSpacing;
+}
+
+bool StyleMetrics::operator!=(const StyleMetrics &other) const {
+    return !(*this == other);
+}
+
+StyleMetrics styleMetrics(const QStyle *style, qreal devicePixelRatio) {
+    auto &cache = metricsCache();
+    const auto key = StyleMetricsKey(style, dprToPercent(devicePixelRatio));
+    auto it = cache.find(key);
+    if (it != std::end(cache)) {
+        return it->second;
+    }
+
+    static std::set<const QStyle *> watchedStyles;
+    if (watchedStyles.insert(style).second) {
+        QObject::connect(style, &QObject::destroyed, qApp, [style]() {
+            dropStyleMetrics(style);
+            invalidatedStyles().erase(style);
+            watchedStyles.erase(style);
+        });
+    }
+
+    auto metrics = StyleMetrics();
+    metrics.titleBarHeight = style->pixelMetric(QStyle::PM_TitleBarHeight);
+    metrics.buttonSize = style->pixelMetric(QStyle::PM_TitleBarButtonSize);
+    metrics.buttonIconSize =
+        style->pixelMetric(QStyle::PM_TitleBarButtonIconSize);
+#ifdef _WIN32
+    metrics.captionIconSize = ::GetSystemMetrics(SM_CXSMICON);
+#else
+    metrics.captionIconSize = metrics.buttonIconSize;
+#endif
+    metrics.horizontalSpacing =
+        style->pixelMetric(QStyle::PM_LayoutHorizontalSpacing);
+    cache.emplace(key, metrics);
+    return metrics;
+}
+
+void invalidateStyleMetrics(const QStyle *style) {
+    // A style change reaches every widget of the style in the same pass, so
+    // only the first title bar drops the metrics and the others reuse the
+    // snapshot it computes
+    auto &styles = invalidatedStyles();
+    if (!styles.insert(style).second) {
+        return;
+    }
+    if (styles.size() == 1) {
+        QTimer::singleShot(0, qApp, []() { invalidatedStyles().clear(); });
+    }
+    dropStyleMetrics(style);
+}
+
+const QIcon &fallbackCaptionIcon() {
+    static const QIcon icon = []() -> QIcon {
+#ifdef _WIN32
+        auto winIcon = QIcon();
+        winIcon.addPixmap(QtWinBackports::qt_pixmapFromWinHICON(
+            ::LoadIconW(nullptr, IDI_APPLICATION)));
+        return winIcon;
+#elif !defined(__APPLE__)
+        return QIcon::fromTheme("application-x-executable");
+#else
+        return QIcon();
+#endif
+    }();
+    return icon;
+}
+
+} // namespace CSD::Internal
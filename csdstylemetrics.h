@@ -0,0 +1,32 @@
+#pragma once
+
+#include <QIcon>
+#include <QtGlobal>
+
+class QStyle;
+
+namespace CSD::Internal {
+
+// Snapshot of the style metrics a TitleBar is laid out with
+struct StyleMetrics {
+    int titleBarHeight = 0;
+    int buttonSize = 0;
+    int buttonIconSize = 0;
+    int captionIconSize = 0;
+    int horizontalSpacing = 0;
+
+    bool operator==(const StyleMetrics &other) const;
+    bool operator!=(const StyleMetrics &other) const;
+};
+
+// Metrics shared by all title bars with the same style and device pixel
+// ratio. Computed on first use and dropped by invalidateStyleMetrics() or
+// when the style is destroyed. Repeated invalidations of a style within one
+// event loop pass drop its metrics only once.
+StyleMetrics styleMetrics(const QStyle *style, qreal devicePixelRatio);
+void invalidateStyleMetrics(const QStyle *style);
+
+// Caption icon used when neither the title bar nor the application has one
+const QIcon &fallbackCaptionIcon();
+
+} // namespace CSD::Internal
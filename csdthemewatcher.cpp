@@ -0,0 +1,224 @@
+#include "csdthemewatcher.h"
+
+#include "csdtitlebar.h"
+
+#ifdef _WIN32
+#include "qregistrywatcher.h"
+
+#include <Windows.h>
+#endif
+
+#include <QApplication>
+#include <QPalette>
+#include <QPointer>
+#include <QTimerEvent>
+
+#if !defined(_WIN32) && !defined(__APPLE__)
+#include <QDir>
+#include <QFileInfo>
+#include <QFileSystemWatcher>
+#include <QSettings>
+#include <QStandardPaths>
+#endif
+
+#include <algorithm>
+#include <iterator>
+#include <optional>
+
+namespace CSD::Internal {
+
+#ifdef _WIN32
+static std::optional<QColor> readDWMColorizationColor() {
+    auto handleKey = ::HKEY();
+    auto regOpenResult = ::RegOpenKeyExW(HKEY_CURRENT_USER,
+                                         L"SOFTWARE\\Microsoft\\Windows\\DWM",
+                                         0,
+                                         KEY_READ,
+                                         &handleKey);
+    if (regOpenResult != ERROR_SUCCESS) {
+        return std::nullopt;
+    }
+    auto value = ::DWORD();
+    auto dwordBufferSize = ::DWORD(sizeof(::DWORD));
+    auto regQueryResult = ::RegQueryValueExW(handleKey,
+                                             L"ColorizationColor",
+                                             nullptr,
+                                             nullptr,
+                                             reinterpret_cast<LPBYTE>(&value),
+                                             &dwordBufferSize);
+    ::RegCloseKey(handleKey);
+    if (regQueryResult != ERROR_SUCCESS) {
+        return std::nullopt;
+    }
+    return QColor(static_cast<QRgb>(value));
+}
+#endif
+
+#if !defined(_WIN32) && !defined(__APPLE__)
+static QString configPath(const QString &fileName) {
+    return QStandardPaths::writableLocation(
+               QStandardPaths::GenericConfigLocation) +
+           QLatin1Char('/') + fileName;
+}
+
+// KConfig stores colors as "r,g,b", which QSettings reads as a string list
+static std::optional<QColor> readKdeColor(const QSettings &settings,
+                                          const QString &key) {
+    const auto parts = settings.value(key).toStringList();
+    if (parts.size() < 3) {
+        return std::nullopt;
+    }
+    auto color = QColor(parts[0].toInt(), parts[1].toInt(), parts[2].toInt());
+    if (!color.isValid()) {
+        return std::nullopt;
+    }
+    return color;
+}
+
+static std::optional<QColor> readKdeAccentColor() {
+    const auto path = configPath(QStringLiteral("kdeglobals"));
+    if (!QFileInfo::exists(path)) {
+        return std::nullopt;
+    }
+    const auto settings = QSettings(path, QSettings::IniFormat);
+    auto color = readKdeColor(settings, QStringLiteral("General/AccentColor"));
+    if (!color.has_value()) {
+        color = readKdeColor(settings, QStringLiteral("WM/activeBackground"));
+    }
+    return color;
+}
+#endif
+
+ThemeWatcher &ThemeWatcher::instance() {
+    // Owned by the application like the glyph cache
+    static QPointer<ThemeWatcher> watcher;
+    if (watcher.isNull()) {
+        watcher = new ThemeWatcher(qApp);
+    }
+    return *watcher;
+}
+
+ThemeWatcher::ThemeWatcher(QObject *parent) : QObject(parent) {
+#ifdef _WIN32
+    auto maybeWatcher = QRegistryWatcher::create(
+        HKEY_CURRENT_USER, L"SOFTWARE\\Microsoft\\Windows\\DWM", this);
+    if (maybeWatcher.has_value()) {
+        this->m_registryWatcher = *maybeWatcher;
+        connect(
+            this->m_registryWatcher,
+            &QRegistryWatcher::valueChanged,
+            this,
+            [this]() { this->scheduleRefresh(); },
+            Qt::QueuedConnection);
+    }
+#elif !defined(__APPLE__)
+    this->m_fileWatcher = new QFileSystemWatcher(this);
+    connect(this->m_fileWatcher,
+            &QFileSystemWatcher::fileChanged,
+            this,
+            [this]() {
+                this->watchFiles();
+                this->scheduleRefresh();
+            });
+    // Settings are usually saved by writing a new file and renaming it over
+    // the old one, which drops the file watch. Watching the directories lets
+    // the files be picked up again.
+    connect(this->m_fileWatcher,
+            &QFileSystemWatcher::directoryChanged,
+            this,
+            [this]() {
+                if (this->watchFiles()) {
+                    this->scheduleRefresh();
+                }
+            });
+    this->watchFiles();
+#endif
+    this->m_accentColor = this->readAccentColor();
+}
+
+#if !defined(_WIN32) && !defined(__APPLE__)
+// GTK's settings.ini only names a theme and has no accent color. A GTK theme
+// switch reaches the application as a palette change through the platform
+// theme, which the title bars forward to scheduleRefresh().
+bool ThemeWatcher::watchFiles() {
+    const auto file = configPath(QStringLiteral("kdeglobals"));
+    const auto directory = QFileInfo(file).absolutePath();
+    if (QDir(directory).exists() &&
+        !this->m_fileWatcher->directories().contains(directory)) {
+        this->m_fileWatcher->addPath(directory);
+    }
+    if (this->m_fileWatcher->files().contains(file) ||
+        !QFileInfo::exists(file)) {
+        return false;
+    }
+    return this->m_fileWatcher->addPath(file);
+}
+#endif
+
+QColor ThemeWatcher::accentColor() const {
+    return this->m_accentColor;
+}
+
+QColor ThemeWatcher::readAccentColor() const {
+#ifdef _WIN32
+    auto maybeColor = readDWMColorizationColor();
+#elif !defined(__APPLE__)
+    auto maybeColor = readKdeAccentColor();
+#else
+    auto maybeColor = std::optional<QColor>();
+#endif
+    if (maybeColor.has_value()) {
+        return *maybeColor;
+    }
+    return QApplication::palette().color(QPalette::Active, QPalette::Window);
+}
+
+void ThemeWatcher::registerTitleBar(TitleBar *titleBar) {
+    if (std::find(std::begin(this->m_titleBars),
+                  std::end(this->m_titleBars),
+                  titleBar) != std::end(this->m_titleBars)) {
+        return;
+    }
+    this->m_titleBars.push_back(titleBar);
+    connect(titleBar, &QObject::destroyed, this, [this](QObject *object) {
+        auto it = std::find_if(std::begin(this->m_titleBars),
+                               std::end(this->m_titleBars),
+                               [object](TitleBar *titleBar) {
+                                   return static_cast<QObject *>(titleBar) ==
+                                          object;
+                               });
+        if (it != std::end(this->m_titleBars)) {
+            this->m_titleBars.erase(it);
+        }
+    });
+}
+
+void ThemeWatcher::scheduleRefresh() {
+    // Restarting the timer keeps pushing the refresh back while a burst of
+    // notifications is still arriving
+    this->m_debounceTimer.start(debounceMs, this);
+}
+
+void ThemeWatcher::timerEvent(QTimerEvent *event) {
+    if (event->timerId() != this->m_debounceTimer.timerId()) {
+        QObject::timerEvent(event);
+        return;
+    }
+    this->m_debounceTimer.stop();
+    this->refresh();
+}
+
+void ThemeWatcher::refresh() {
+    const auto color = this->readAccentColor();
+    if (color == this->m_accentColor) {
+        return;
+    }
+    this->m_accentColor = color;
+    // Each title bar only marks its palette dirty here, the commits are
+    // queued and all run in the same event loop pass
+    for (TitleBar *titleBar : this->m_titleBars) {
+        titleBar->onAccentColorChange(color);
+    }
+}
+
+} // namespace CSD::Internal
@@ -0,0 +1,60 @@
+#pragma once
+
+#include <QBasicTimer>
+#include <QColor>
+#include <QObject>
+
+#include <vector>
+
+#ifdef _WIN32
+class QRegistryWatcher;
+#else
+class QFileSystemWatcher;
+#endif
+
+namespace CSD {
+
+class TitleBar;
+
+namespace Internal {
+
+// Application-wide source of the system accent color. The platform theme
+// settings are watched once per process, bursts of change notifications are
+// coalesced, and a changed color is pushed to every registered TitleBar in a
+// single pass.
+class ThemeWatcher final : public QObject {
+    Q_OBJECT
+
+public:
+    static constexpr int debounceMs = 100;
+
+    static ThemeWatcher &instance();
+
+    QColor accentColor() const;
+    void registerTitleBar(TitleBar *titleBar);
+    void scheduleRefresh();
+
+protected:
+    void timerEvent(QTimerEvent *event) override;
+
+private:
+    explicit ThemeWatcher(QObject *parent = nullptr);
+    void refresh();
+    QColor readAccentColor() const;
+#if !defined(_WIN32) && !defined(__APPLE__)
+    bool watchFiles();
+
+    QFileSystemWatcher *m_fileWatcher = nullptr;
+#endif
+#ifdef _WIN32
+    QRegistryWatcher *m_registryWatcher = nullptr;
+#endif
+
+    QColor m_accentColor;
+    std::vector<TitleBar *> m_titleBars;
+    QBasicTimer m_debounceTimer;
+};
+
+} // namespace Internal
+
+} // namespace CSD
@@ -1,11 +1,19 @@
 #include "csdtitlebar.h"
 
+#include "csdcaptionstatetable.h"
+#include "csdfadedriver.h"
+#include "csdglyphcache.h"
+#include "csdmenubararea.h"
+#include "csdstylemetrics.h"
+#include "csdthemewatcher.h"
 #include "csdtitlebarbutton.h"
 
-#ifdef _WIN32
-#include "qregistrywatcher.h"
-#include "qtwinbackports.h"
+#if !defined(_WIN32) && !defined(__APPLE__)
+#include "linuxclientmove.h"
+#include "linuxxcb.h"
+#endif
 
+#ifdef _WIN32
 #include <Windows.h>
 #include <dwmapi.h>
 #endif
@@ -15,28 +23,37 @@
 #include <QEvent>
 #include <QMainWindow>
 #include <QMenuBar>
+#include <QMouseEvent>
+#include <QPaintEvent>
 #include <QPainter>
+#include <QResizeEvent>
 #include <QStyleOption>
 #include <QTimer>
-
-#if !defined(_WIN32) && !defined(__APPLE__)
-#include <QMouseEvent>
+#include <QTimerEvent>
 #include <QWindow>
 
+#include <algorithm>
+#include <iterator>
+#include <limits>
+#include <utility>
+
+#if !defined(_WIN32) && !defined(__APPLE__)
 #include <QX11Info>
 
 #include <private/qhighdpiscaling_p.h>
 #include <qpa/qplatformscreen.h>
 #include <qpa/qplatformwindow.h>
-
-#include <cstring>
 #endif
 
 namespace CSD {
 
-#if !defined(_WIN32) && !defined(__APPLE__)
-constexpr static const char _NET_WM_MOVERESIZE[] = "_NET_WM_MOVERESIZE";
+static_assert(Internal::captionStateCount ==
+                  Internal::captionStateIndex(
+                      true, true, true, true, CaptionButtonStyle::mac) +
+                      1,
+              "caption state table does not cover every style and state");
 
+#if !defined(_WIN32) && !defined(__APPLE__)
 static QWidget *titleBarTopLevelWidget(QWidget *w) {
     while (w && !w->isWindow() && w->windowType() != Qt::SubWindow) {
         w = w->parentWidget();
@@ -47,63 +64,25 @@ static QWidget *titleBarTopLevelWidget(QWidget *w) {
 
 TitleBar::TitleBar(CaptionButtonStyle captionButtonStyle,
                    const QIcon &captionIcon,
-                   QWidget *parent)
-    : QWidget(parent), m_captionButtonStyle(captionButtonStyle) {
+                   QWidget *parent,
+                   TitleBarMode mode)
+    : QWidget(parent), m_captionButtonStyle(captionButtonStyle),
+      m_mode(mode) {
+    const auto span = Instrumentation::TraceSpan("TitleBar::TitleBar");
     this->setObjectName("TitleBar");
-    int headerHeight = style()->pixelMetric(QStyle::PM_TitleBarHeight);
-    int headerButtonSize = style()->pixelMetric(QStyle::PM_TitleBarButtonSize);
-    this->setMinimumSize(QSize(0, headerHeight)); // was 30
-    this->setMaximumSize(QSize(QWIDGETSIZE_MAX, headerHeight)); // was 30
-#ifdef _WIN32
-    auto maybeColor = this->readDWMColorizationColor();
-    if (maybeColor.has_value()) {
-        this->m_activeColor = *maybeColor;
-    }
-#ifdef _WIN32
-    auto maybeWatcher = QRegistryWatcher::create(
-        HKEY_CURRENT_USER, L"SOFTWARE\\Microsoft\\Windows\\DWM", this);
-    if (maybeWatcher.has_value()) {
-        this->m_watcher = *maybeWatcher;
-        connect(
-            this->m_watcher,
-            &QRegistryWatcher::valueChanged,
-            this,
-            [this]() {
-                auto maybeColor = this->readDWMColorizationColor();
-                if (maybeColor.has_value() && !this->m_activeColorOverridden) {
-                    this->m_activeColor = *maybeColor;
-                    this->update();
-                }
-            },
-            Qt::QueuedConnection);
+#if !defined(_WIN32) && !defined(__APPLE__)
+    if (QX11Info::isPlatformX11()) {
+        // Intern the atoms now so that the first drag doesn't wait for them
+        Internal::XcbConnectionCache::forConnection(QX11Info::connection());
     }
 #endif
-#endif
-    int spacing = style()->pixelMetric(QStyle::PM_LayoutHorizontalSpacing);
-    this->m_horizontalLayout = new QHBoxLayout(this);
-    this->m_horizontalLayout->setSpacing(spacing); // was 0
-    this->m_horizontalLayout->setObjectName("HorizontalLayout");
-    this->m_horizontalLayout->setContentsMargins(0, 0, 0, 0);
-
-    this->m_leftMargin = new QWidget(this);
-    this->m_leftMargin->setObjectName("LeftMargin");
-    this->m_leftMargin->setMinimumSize(QSize(5, 0));
-    this->m_leftMargin->setMaximumSize(QSize(5, QWIDGETSIZE_MAX));
-    this->m_horizontalLayout->addWidget(this->m_leftMargin);
+    auto &themeWatcher = Internal::ThemeWatcher::instance();
+    this->m_activeColor = themeWatcher.accentColor();
+    themeWatcher.registerTitleBar(this);
 
-    this->m_buttonCaptionIcon =
-        new TitleBarButton(TitleBarButton::CaptionIcon, this);
-    this->m_buttonCaptionIcon->setObjectName("ButtonCaptionIcon");
-    this->m_buttonCaptionIcon->setMinimumSize(QSize(headerButtonSize, headerButtonSize)); //was 30x30
-    this->m_buttonCaptionIcon->setMaximumSize(QSize(headerButtonSize, headerButtonSize));
-    this->m_buttonCaptionIcon->setFocusPolicy(Qt::NoFocus);
-#ifdef _WIN32
-    int icon_size = ::GetSystemMetrics(SM_CXSMICON);
-#else
-    int icon_size = style()->pixelMetric(QStyle::PM_TitleBarButtonIconSize); //was 16;
-#endif
-    this->m_buttonCaptionIcon->setIconSize(QSize(icon_size, icon_size));
-    const auto icon = [&captionIcon, this]() -> QIcon {
+    bool leftMargin = true;
+    const auto icon = [&captionIcon, &leftMargin, this]() -> QIcon {
+        const auto span = Instrumentation::TraceSpan("TitleBar caption icon");
         if (!captionIcon.isNull()) {
             return captionIcon;
         }
@@ -117,42 +96,67 @@ TitleBar::TitleBar(CaptionButtonStyle captionButtonStyle,
         }
 #ifdef _WIN32
         // Use system default application icon which doesn't need margin
-        this->m_horizontalLayout->takeAt(
-            this->m_horizontalLayout->indexOf(this->m_leftMargin));
-        this->m_leftMargin->setParent(nullptr);
-        HICON winIcon = ::LoadIconW(nullptr, IDI_APPLICATION);
-        globalWindowIcon.addPixmap(
-            QtWinBackports::qt_pixmapFromWinHICON(winIcon));
-#else
-#if !defined(__APPLE__)
-        if (globalWindowIcon.isNull()) {
-            globalWindowIcon = QIcon::fromTheme("application-x-executable");
-        }
-#endif
+        leftMargin = false;
 #endif
-        return globalWindowIcon;
+        return Internal::fallbackCaptionIcon();
     }();
-    this->m_buttonCaptionIcon->setIcon(icon);
-    this->m_horizontalLayout->addWidget(this->m_buttonCaptionIcon);
 
     auto *mainWindow = qobject_cast<QMainWindow *>(this->window());
     if (mainWindow != nullptr) {
         this->m_menuBar = mainWindow->menuBar();
-        this->m_horizontalLayout->addWidget(this->m_menuBar);
-        this->m_menuBar->setFixedHeight(headerHeight); //was 30
+        this->m_menuBarArea =
+            new Internal::MenuBarArea(this->m_menuBar, this);
+        this->setDraggable(this->m_menuBarArea, false);
+    }
+
+    this->m_captionIconMargin = leftMargin;
+    if (mode == TitleBarMode::Painted) {
+        this->m_captionIcon = icon;
+        this->setMouseTracking(true);
+    } else {
+        this->createCaptionWidgets(icon, leftMargin);
+    }
+
+    this->applyStyleMetrics();
+    this->setAutoFillBackground(true);
+    this->m_active = this->window()->isActiveWindow();
+    this->m_maximized = static_cast<bool>(this->window()->windowState() &
+                                          Qt::WindowMaximized);
+    this->m_dirty = DirtyPalette | DirtyCaptionButtons;
+    this->commitPendingUpdates();
+}
+
+void TitleBar::createCaptionWidgets(const QIcon &captionIcon,
+                                    bool leftMargin) {
+    this->m_fadeDriver = new Internal::FadeDriver(this, &this->m_counters);
+    this->m_horizontalLayout = new QHBoxLayout(this);
+    this->m_horizontalLayout->setObjectName("HorizontalLayout");
+    this->m_horizontalLayout->setContentsMargins(0, 0, 0, 0);
+
+    if (leftMargin) {
+        this->m_leftMargin = new QWidget(this);
+        this->m_leftMargin->setObjectName("LeftMargin");
+        this->m_horizontalLayout->addWidget(this->m_leftMargin);
+    }
+
+    this->m_buttonCaptionIcon =
+        new TitleBarButton(TitleBarButton::CaptionIcon, this);
+    this->m_buttonCaptionIcon->setObjectName("ButtonCaptionIcon");
+    this->m_buttonCaptionIcon->setFocusPolicy(Qt::NoFocus);
+    this->m_buttonCaptionIcon->setIcon(captionIcon);
+    this->m_horizontalLayout->addWidget(this->m_buttonCaptionIcon);
+
+    if (this->m_menuBarArea != nullptr) {
+        this->m_horizontalLayout->addWidget(this->m_menuBarArea);
     }
 
     auto *emptySpace = new QWidget(this);
     emptySpace->setAttribute(Qt::WA_TransparentForMouseEvents);
     this->m_horizontalLayout->addWidget(emptySpace, 1);
-    int headerIconSize = style()->pixelMetric(QStyle::PM_TitleBarButtonIconSize);
     this->m_buttonMinimize =
         new TitleBarButton(TitleBarButton::Minimize, this);
     this->m_buttonMinimize->setObjectName("ButtonMinimize");
-    this->m_buttonMinimize->setMinimumSize(QSize(headerButtonSize, headerButtonSize));
-    this->m_buttonMinimize->setMaximumSize(QSize(headerButtonSize, headerButtonSize));
     this->m_buttonMinimize->setFocusPolicy(Qt::NoFocus);
-    this->m_buttonMinimize->setIconSize(QSize(headerIconSize, headerIconSize));
     this->m_horizontalLayout->addWidget(this->m_buttonMinimize);
     connect(this->m_buttonMinimize, &QPushButton::clicked, this, [this]() {
         emit this->minimizeClicked();
@@ -161,12 +165,7 @@ TitleBar::TitleBar(CaptionButtonStyle captionButtonStyle,
     this->m_buttonMaximizeRestore =
         new TitleBarButton(TitleBarButton::MaximizeRestore, this);
     this->m_buttonMaximizeRestore->setObjectName("ButtonMaximizeRestore");
-    this->m_buttonMaximizeRestore->setMinimumSize(
-        QSize(headerButtonSize, headerButtonSize));
-    this->m_buttonMaximizeRestore->setMaximumSize(
-        QSize(headerButtonSize, headerButtonSize));
     this->m_buttonMaximizeRestore->setFocusPolicy(Qt::NoFocus);
-    this->m_buttonMaximizeRestore->setIconSize(QSize(headerIconSize, headerIconSize));
     this->m_horizontalLayout->addWidget(this->m_buttonMaximizeRestore);
     connect(this->m_buttonMaximizeRestore,
             &QPushButton::clicked,
@@ -175,48 +174,23 @@ TitleBar::TitleBar(CaptionButtonStyle captionButtonStyle,
 
     this->m_buttonClose = new TitleBarButton(TitleBarButton::Close, this);
     this->m_buttonClose->setObjectName("ButtonClose");
-    this->m_buttonClose->setMinimumSize(QSize(headerButtonSize, headerIconSize));
-    this->m_buttonClose->setMaximumSize(QSize(headerButtonSize, headerIconSize));
     this->m_buttonClose->setFocusPolicy(Qt::NoFocus);
-    this->m_buttonClose->setIconSize(QSize(headerIconSize, headerIconSize));
     this->m_horizontalLayout->addWidget(this->m_buttonClose);
     connect(this->m_buttonClose, &QPushButton::clicked, this, [this]() {
         emit this->closeClicked();
     });
 
-    this->setAutoFillBackground(true);
-    this->setActive(this->window()->isActiveWindow());
-    this->setMaximized(static_cast<bool>(this->window()->windowState() &
-                                         Qt::WindowMaximized));
-}
-
-#ifdef _WIN32
-std::optional<QColor> TitleBar::readDWMColorizationColor() {
-    auto handleKey = ::HKEY();
-    auto regOpenResult = ::RegOpenKeyExW(HKEY_CURRENT_USER,
-                                         L"SOFTWARE\\Microsoft\\Windows\\DWM",
-                                         0,
-                                         KEY_READ,
-                                         &handleKey);
-    if (regOpenResult != ERROR_SUCCESS) {
-        return std::nullopt;
-    }
-    auto value = ::DWORD();
-    auto dwordBufferSize = ::DWORD(sizeof(::DWORD));
-    auto regQueryResult = ::RegQueryValueExW(handleKey,
-                                             L"ColorizationColor",
-                                             nullptr,
-                                             nullptr,
-                                             reinterpret_cast<LPBYTE>(&value),
-                                             &dwordBufferSize);
-    if (regQueryResult != ERROR_SUCCESS) {
-        return std::nullopt;
-    }
-    return QColor(static_cast<QRgb>(value));
+    this->setDraggable(this->m_buttonCaptionIcon, false);
+    this->setDraggable(this->m_buttonMinimize, false);
+    this->setDraggable(this->m_buttonMaximizeRestore, false);
+    this->setDraggable(this->m_buttonClose, false);
 }
-#endif
 
 TitleBar::~TitleBar() {
+    if constexpr (Instrumentation::enabled) {
+        Instrumentation::logCounters(
+            qPrintable(this->window()->objectName()), this->m_counters);
+    }
     auto *mainWindow = qobject_cast<QMainWindow *>(this->window());
     if (mainWindow != nullptr) {
         mainWindow->setMenuBar(this->m_menuBar);
@@ -224,13 +198,24 @@ TitleBar::~TitleBar() {
     this->m_menuBar = nullptr;
 }
 
-#if !defined(_WIN32) && !defined(__APPLE__)
 void TitleBar::mousePressEvent(QMouseEvent *event) {
-    if (!QX11Info::isPlatformX11() || event->button() != Qt::LeftButton) {
+    if (this->m_mode == TitleBarMode::Painted &&
+        event->button() == Qt::LeftButton) {
+        const int part = this->partAt(event->pos());
+        if (this->m_captionButtonStates.press(part)) {
+            this->updatePart(static_cast<TitleBarButton::Role>(part));
+            return;
+        }
+    }
+#if !defined(_WIN32) && !defined(__APPLE__)
+    if (!QX11Info::isPlatformX11() || event->button() != Qt::LeftButton ||
+        !this->isDragArea(event->pos())) {
         QWidget::mousePressEvent(event);
         return;
     }
 
+    const auto span =
+        Instrumentation::TraceSpan("TitleBar press to _NET_WM_MOVERESIZE");
     QWidget *tlw = titleBarTopLevelWidget(this);
 
     if (tlw->isWindow() && tlw->windowHandle() &&
@@ -238,93 +223,505 @@ void TitleBar::mousePressEvent(QMouseEvent *event) {
         !tlw->testAttribute(Qt::WA_DontShowOnScreen) &&
         !tlw->hasHeightForWidth()) {
         QPlatformWindow *platformWindow = tlw->windowHandle()->handle();
+        const int screenNumber =
+            Internal::xcbScreenNumber(tlw->windowHandle()->screen());
+        auto &connectionCache = Internal::XcbConnectionCache::forConnection(
+            QX11Info::connection());
+        const bool windowManagerMove =
+            this->m_moveStrategy == MoveStrategy::WindowManager ||
+            (this->m_moveStrategy == MoveStrategy::Automatic &&
+             connectionCache.isMoveResizeSupported(screenNumber));
+        if (!windowManagerMove) {
+            if (this->m_clientMove == nullptr) {
+                this->m_clientMove =
+                    new Internal::ClientMove(&this->m_counters, this);
+            }
+            this->m_clientMove->start(
+                tlw->windowHandle(),
+                QHighDpi::toNativePixels(event->globalPos(),
+                                         tlw->windowHandle()->screen()));
+            return;
+        }
+
         const QPoint globalPos = QHighDpi::toNativePixels(
             platformWindow->mapToGlobal(this->mapTo(tlw, event->pos())),
             platformWindow->screen()->screen());
+        connectionCache.startMoveResize(
+            static_cast<xcb_window_t>(platformWindow->winId()),
+            screenNumber,
+            globalPos.x(),
+            globalPos.y(),
+            Internal::XcbConnectionCache::Move);
+    }
+#else
+    QWidget::mousePressEvent(event);
+#endif
+}
 
-        const xcb_atom_t moveResizeAtom = []() -> xcb_atom_t {
-            xcb_intern_atom_cookie_t cookie = xcb_intern_atom(
-                QX11Info::connection(),
-                false,
-                static_cast<std::uint16_t>(std::strlen(_NET_WM_MOVERESIZE)),
-                _NET_WM_MOVERESIZE);
-            xcb_intern_atom_reply_t *reply =
-                xcb_intern_atom_reply(QX11Info::connection(), cookie, nullptr);
-            const xcb_atom_t moveResizeAtomCopy = reply->atom;
-            free(reply);
-            return moveResizeAtomCopy;
-        }();
-
-        xcb_client_message_event_t xev;
-        xev.response_type = XCB_CLIENT_MESSAGE;
-        xev.type = moveResizeAtom;
-        xev.sequence = 0;
-        xev.window = static_cast<xcb_window_t>(platformWindow->winId());
-        xev.format = 32;
-        xev.data.data32[0] = static_cast<std::uint32_t>(globalPos.x());
-        xev.data.data32[1] = static_cast<std::uint32_t>(globalPos.y());
-        xev.data.data32[2] = 8; // move
-        xev.data.data32[3] = XCB_BUTTON_INDEX_1;
-        xev.data.data32[4] = 0;
-
-        const xcb_window_t rootWindow = [platformWindow]() -> xcb_window_t {
-            xcb_query_tree_cookie_t queryTreeCookie = xcb_query_tree(
-                QX11Info::connection(),
-                static_cast<xcb_window_t>(platformWindow->winId()));
-            xcb_query_tree_reply_t *queryTreeReply = xcb_query_tree_reply(
-                QX11Info::connection(), queryTreeCookie, nullptr);
-            xcb_window_t rootWindowCopy = queryTreeReply->root;
-            free(queryTreeReply);
-            return rootWindowCopy;
-        }();
-
-        std::uint32_t eventFlags = XCB_EVENT_MASK_SUBSTRUCTURE_REDIRECT |
-                                   XCB_EVENT_MASK_SUBSTRUCTURE_NOTIFY;
-
-        xcb_ungrab_pointer(QX11Info::connection(), XCB_CURRENT_TIME);
-        xcb_send_event(QX11Info::connection(),
-                       false,
-                       rootWindow,
-                       eventFlags,
-                       reinterpret_cast<const char *>(&xev));
+void TitleBar::mouseMoveEvent(QMouseEvent *event) {
+#if !defined(_WIN32) && !defined(__APPLE__)
+    if (this->m_clientMove != nullptr && this->m_clientMove->isActive()) {
+        this->m_clientMove->update(QHighDpi::toNativePixels(
+            event->globalPos(), this->window()->windowHandle()->screen()));
+        return;
+    }
+#endif
+    this->m_dragAreaHovered = this->isDragArea(event->pos());
+    if (this->m_mode == TitleBarMode::Painted) {
+        this->setHoveredPart(this->partAt(event->pos()));
     }
+    QWidget::mouseMoveEvent(event);
 }
+
+void TitleBar::mouseReleaseEvent(QMouseEvent *event) {
+    const int pressed = this->m_captionButtonStates.pressed();
+    if (pressed != Internal::CaptionButtonStates::none &&
+        event->button() == Qt::LeftButton) {
+        this->updatePart(static_cast<TitleBarButton::Role>(pressed));
+        const int clicked =
+            this->m_captionButtonStates.release(this->partAt(event->pos()));
+        switch (clicked) {
+        case TitleBarButton::Minimize:
+            emit this->minimizeClicked();
+            break;
+        case TitleBarButton::MaximizeRestore:
+            emit this->maximizeRestoreClicked();
+            break;
+        case TitleBarButton::Close:
+            emit this->closeClicked();
+            break;
+        default:
+            break;
+        }
+        return;
+    }
+#if !defined(_WIN32) && !defined(__APPLE__)
+    if (this->m_clientMove != nullptr && this->m_clientMove->isActive() &&
+        event->button() == Qt::LeftButton) {
+        this->m_clientMove->finish();
+        return;
+    }
 #endif
+    QWidget::mouseReleaseEvent(event);
+}
+
+static quint64 regionArea(const QRegion &region) {
+    quint64 area = 0;
+    for (const QRect &rect : region) {
+        area += static_cast<quint64>(rect.width()) *
+                static_cast<quint64>(rect.height());
+    }
+    return area;
+}
 
-void TitleBar::paintEvent([[maybe_unused]] QPaintEvent *event) {
+// PE_Widget draws nothing unless a style sheet applies, and without one the
+// auto-filled palette color is the whole background
+static bool styleSheetDrawsBackground(const QWidget *widget) {
+    return widget->style()->inherits("QStyleSheetStyle");
+}
+
+void TitleBar::updateBackgroundCache() {
+    // A theme's background reaches the palette like the plain colors do
+    if (this->m_theme.has_value() || !styleSheetDrawsBackground(this)) {
+        this->m_background = QPixmap();
+        return;
+    }
+    // Style sheet backgrounds may depend on the width, such as borders and
+    // gradients, so they are cached at the exact size
+    const auto dpr = this->devicePixelRatioF();
+    const auto color = this->palette().color(QPalette::Window);
+    const auto pixelSize = this->size() * dpr;
+    if (!this->m_background.isNull() &&
+        this->m_background.size() == pixelSize &&
+        this->m_backgroundColor == color &&
+        qFuzzyCompare(this->m_backgroundDpr, dpr)) {
+        return;
+    }
+
+    this->m_background = QPixmap(pixelSize);
+    this->m_background.setDevicePixelRatio(dpr);
+    this->m_background.fill(Qt::transparent);
+    this->m_backgroundColor = color;
+    this->m_backgroundDpr = dpr;
+
+    auto painter = QPainter(&this->m_background);
     auto styleOption = QStyleOption();
     styleOption.init(this);
-    auto painter = QPainter(this);
     this->style()->drawPrimitive(
         QStyle::PE_Widget, &styleOption, &painter, this);
 }
 
-bool TitleBar::isActive() const {
-    return this->m_active;
+void TitleBar::paintEvent(QPaintEvent *event) {
+    Instrumentation::count(&this->m_counters, Instrumentation::TitleBarPaints);
+    const auto timer = Instrumentation::ScopedTimer(
+        &this->m_counters, Instrumentation::TitleBarPaintNs);
+    const auto firstPaintSpan = Instrumentation::TraceSpan(
+        this->m_firstPaintDone ? nullptr : "TitleBar first paint");
+    this->m_firstPaintDone = true;
+    this->m_paintedArea += regionArea(event->region());
+    if (this->m_liveResizing) {
+        // Keep the stale background, the auto-filled window color covers the
+        // newly exposed middle, and the caption buttons come from their
+        // snapshot
+        auto painter = QPainter(this);
+        painter.setClipRegion(event->region());
+        painter.drawPixmap(0, 0, this->m_background);
+        painter.drawPixmap(this->liveResizeButtonsRect().topLeft(),
+                           this->m_liveResizeButtons);
+        return;
+    }
+    this->updateBackgroundCache();
+    auto painter = QPainter(this);
+    painter.setClipRegion(event->region());
+    if (!this->m_background.isNull()) {
+        painter.drawPixmap(0, 0, this->m_background);
+    }
+    if (this->m_mode == TitleBarMode::Painted) {
+        this->paintParts(painter);
+    }
 }
 
-void TitleBar::setActive(bool active) {
-    this->m_active = active;
-    if (active) {
-        auto palette = this->palette();
-        palette.setColor(QPalette::Window, this->m_activeColor);
-        this->setPalette(palette);
+void TitleBar::paintParts(QPainter &painter) {
+    const auto &metrics = this->m_styleMetrics;
+    const auto direction = this->layoutDirection();
+    const auto &parts = this->m_captionLayout.parts;
+    const auto &captionRect = parts[TitleBarButton::CaptionIcon];
+    if (!captionRect.isNull() && this->m_theme.has_value()) {
+        const auto &pixmap = this->isEnabled()
+                                 ? this->m_resolvedTheme.captionIcon
+                                 : this->m_resolvedTheme.disabledCaptionIcon;
+        const auto iconRect = QStyle::alignedRect(
+            direction,
+            Qt::AlignCenter,
+            pixmap.size() / pixmap.devicePixelRatio(),
+            captionRect);
+        painter.drawPixmap(iconRect.topLeft(), pixmap);
+    } else if (!captionRect.isNull()) {
+        const auto iconRect = QStyle::alignedRect(
+            direction,
+            Qt::AlignCenter,
+            QSize(metrics.captionIconSize, metrics.captionIconSize),
+            captionRect);
+        this->m_captionIcon.paint(&painter,
+                                  iconRect,
+                                  Qt::AlignCenter,
+                                  this->isEnabled() ? QIcon::Normal
+                                                    : QIcon::Disabled);
+    }
+
+    // Like the widgets, mac style never fills the hovered button
+    const auto &states = this->m_captionButtonStates;
+    const bool macStyle =
+        this->captionButtonStyle() == CaptionButtonStyle::mac;
+    const auto iconSize =
+        QSize(metrics.buttonIconSize, metrics.buttonIconSize);
+    for (const auto role : {TitleBarButton::Minimize,
+                            TitleBarButton::MaximizeRestore,
+                            TitleBarButton::Close}) {
+        const auto &rect = parts[role];
+        if (rect.isNull()) {
+            continue;
+        }
+        const bool hovered =
+            this->isEnabled() &&
+            states.isHovered(role, this->captionButtonStyle());
+        const bool pressed = hovered && states.isPressed(role);
+        const auto fill = this->hoverFill(role);
+        if (hovered && !macStyle) {
+            painter.fillRect(rect, fill);
+        }
+        const auto tint = Internal::captionGlyphTint(
+            this->captionButtonStyle(),
+            role,
+            this->m_active,
+            hovered,
+            this->palette().color(QPalette::Window),
+            fill);
+        Internal::drawCaptionGlyph(painter,
+                                   rect,
+                                   direction,
+                                   this->captionButtonStyle(),
+                                   role,
+                                   this->m_active,
+                                   this->m_maximized,
+                                   hovered,
+                                   pressed,
+                                   this->devicePixelRatioF(),
+                                   iconSize,
+                                   tint);
+    }
+}
+
+void TitleBar::layoutParts() {
+    this->m_captionLayout =
+        Internal::layoutCaption(this->size(),
+                                this->m_styleMetrics,
+                                this->captionIconMarginWidth(),
+                                this->m_minimizable,
+                                this->m_maximizable,
+                                this->layoutDirection());
+    if (this->m_menuBarArea != nullptr) {
+        const auto &freeArea = this->m_captionLayout.freeArea;
+        auto rect = freeArea;
+        rect.setWidth(qBound(this->m_menuBarArea->minimumSizeHint().width(),
+                             freeArea.width(),
+                             this->m_menuBarArea->sizeHint().width()));
+        this->m_menuBarArea->setGeometry(
+            QStyle::visualRect(this->layoutDirection(), freeArea, rect));
+    }
+    this->invalidateDragIndex();
+}
+
+QColor TitleBar::hoverFill(TitleBarButton::Role role) const {
+    if (this->m_theme.has_value()) {
+        return role == TitleBarButton::Close
+                   ? this->m_resolvedTheme.closeHoverFill
+                   : this->m_resolvedTheme.hoverFill;
+    }
+    return role == TitleBarButton::Close ? TitleBarButton::closeHoverColor()
+                                         : this->m_hoverColor;
+}
+
+int TitleBar::partAt(const QPoint &pos) const {
+    if (!this->isEnabled()) {
+        return Internal::CaptionButtonStates::none;
+    }
+    return Internal::CaptionButtonStates::buttonAt(this->m_captionLayout,
+                                                   pos);
+}
+
+void TitleBar::setHoveredPart(int part) {
+    const int previous = this->m_captionButtonStates.hovered();
+    if (!this->m_captionButtonStates.setHovered(part)) {
+        return;
+    }
+    if (this->captionButtonStyle() == CaptionButtonStyle::mac) {
+        this->triggerCaptionRepaint();
+        return;
+    }
+    for (const int changed : {previous, part}) {
+        if (changed != Internal::CaptionButtonStates::none) {
+            this->updatePart(static_cast<TitleBarButton::Role>(changed));
+        }
+    }
+}
+
+void TitleBar::updatePart(TitleBarButton::Role role) {
+    if (this->m_mode == TitleBarMode::Painted) {
+        this->update(this->m_captionLayout.parts[role]);
+        return;
+    }
+    switch (role) {
+    case TitleBarButton::CaptionIcon:
+        this->m_buttonCaptionIcon->update();
+        break;
+    case TitleBarButton::Minimize:
+        this->m_buttonMinimize->update();
+        break;
+    case TitleBarButton::MaximizeRestore:
+        this->m_buttonMaximizeRestore->update();
+        break;
+    case TitleBarButton::Close:
+        this->m_buttonClose->update();
+        break;
+    }
+}
+
+QRect TitleBar::liveResizeButtonsRect() const {
+    const auto size =
+        this->m_liveResizeButtons.size() /
+        this->m_liveResizeButtons.devicePixelRatio();
+    const int left = this->layoutDirection() == Qt::RightToLeft
+                         ? this->m_liveResizeButtonsOffset
+                         : this->width() - this->m_liveResizeButtonsOffset;
+    return QRect(QPoint(left, this->m_liveResizeButtonsTop), size);
+}
+
+bool TitleBar::isLiveResizing() const {
+    return this->m_liveResizing;
+}
+
+bool TitleBar::isLiveResizeEnabled() const {
+    return this->m_liveResizeEnabled;
+}
+
+void TitleBar::setLiveResizeEnabled(bool enabled) {
+    this->m_liveResizeEnabled = enabled;
+    if (!enabled) {
+        this->endLiveResize();
+    }
+}
+
+void TitleBar::onResizeStep(const QSize &oldSize) {
+    if (std::exchange(this->m_stateChangeResizePending, false) ||
+        !this->m_liveResizeEnabled) {
+        // Maximizing or restoring is a single resize, laid out as usual
+        return;
+    }
+    if (!this->m_liveResizing) {
+        this->beginLiveResize();
     } else {
+        const int delta = this->width() - oldSize.width();
+        if (this->layoutDirection() == Qt::RightToLeft) {
+            // The buttons stay at the left edge, the caption icon and the
+            // menu bar follow the right one
+            for (QWidget *widget :
+                 {static_cast<QWidget *>(this->m_buttonCaptionIcon),
+                  static_cast<QWidget *>(this->m_menuBarArea)}) {
+                if (widget != nullptr) {
+                    widget->move(widget->x() + delta, widget->y());
+                }
+            }
+        } else {
+            // Only the strip the snapshot leaves and the one it moves to
+            // change
+            const auto rect = this->liveResizeButtonsRect();
+            this->update(rect.united(rect.translated(-delta, 0)));
+        }
+    }
+    this->m_liveResizeTimer.start(liveResizeIdleMs, this);
+}
+
+void TitleBar::beginLiveResize() {
+    // The layout already placed everything for this step
+    auto buttonsRect = QRect();
+    for (TitleBarButton *button : {this->m_buttonMinimize,
+                                   this->m_buttonMaximizeRestore,
+                                   this->m_buttonClose}) {
+        if (button->isVisibleTo(this)) {
+            buttonsRect |= button->geometry();
+        }
+    }
+    this->m_liveResizeButtons =
+        buttonsRect.isEmpty() ? QPixmap() : this->grab(buttonsRect);
+    this->m_liveResizeButtonsOffset =
+        this->layoutDirection() == Qt::RightToLeft
+            ? buttonsRect.left()
+            : this->width() - buttonsRect.left();
+    this->m_liveResizeButtonsTop = buttonsRect.top();
+
+    this->m_liveResizing = true;
+    this->m_horizontalLayout->setEnabled(false);
+    this->m_fadeDriver->suspend();
+    this->setAttribute(Qt::WA_StaticContents, true);
+    for (TitleBarButton *button : {this->m_buttonMinimize,
+                                   this->m_buttonMaximizeRestore,
+                                   this->m_buttonClose}) {
+        if (button->isVisibleTo(this)) {
+            button->hide();
+            this->m_liveResizeHiddenButtons.push_back(button);
+        }
+    }
+}
+
+void TitleBar::endLiveResize() {
+    if (!this->m_liveResizing) {
+        return;
+    }
+    this->m_liveResizeTimer.stop();
+    this->m_liveResizing = false;
+    this->setAttribute(Qt::WA_StaticContents, false);
+    for (TitleBarButton *button : this->m_liveResizeHiddenButtons) {
+        button->show();
+    }
+    this->m_liveResizeHiddenButtons.clear();
+    this->m_liveResizeButtons = QPixmap();
+    this->m_horizontalLayout->setEnabled(true);
+    this->m_horizontalLayout->invalidate();
+    this->m_horizontalLayout->activate();
+    this->m_fadeDriver->resume();
+    this->update();
+}
+
+void TitleBar::timerEvent(QTimerEvent *event) {
+    if (event->timerId() != this->m_liveResizeTimer.timerId()) {
+        QWidget::timerEvent(event);
+        return;
+    }
+    this->endLiveResize();
+}
+
+TitleBarMode TitleBar::mode() const {
+    return this->m_mode;
+}
+
+TitleBarState TitleBar::state() const {
+    return TitleBarState{this->m_active, this->m_maximized};
+}
+
+void TitleBar::applyState(const TitleBarState &state) {
+    int dirty = 0;
+    if (state.active != this->m_active) {
+        this->m_active = state.active;
+        dirty |= DirtyPalette | DirtyCaptionButtons;
+    }
+    if (state.maximized != this->m_maximized) {
+        this->m_maximized = state.maximized;
+        this->m_stateChangeResizePending = true;
+        dirty |= DirtyMaximizeRestore;
+    }
+    if (dirty == 0) {
+        ++this->m_droppedUpdates;
+        return;
+    }
+    this->markDirty(dirty);
+}
+
+quint64 TitleBar::committedUpdateCount() const {
+    return this->m_committedUpdates;
+}
+
+quint64 TitleBar::droppedUpdateCount() const {
+    return this->m_droppedUpdates;
+}
+
+void TitleBar::markDirty(int flags) {
+    // The caption button snapshot would show the old state
+    this->endLiveResize();
+    const bool wasClean = this->m_dirty == 0;
+    this->m_dirty |= flags;
+    if (wasClean) {
+        // Everything marked before the event loop comes back is committed
+        // together with a single palette change and repaint
+        QMetaObject::invokeMethod(
+            this,
+            [this]() { this->commitPendingUpdates(); },
+            Qt::QueuedConnection);
+    }
+}
+
+void TitleBar::commitPendingUpdates() {
+    if (this->m_dirty == 0) {
+        return;
+    }
+    const int dirty = this->m_dirty;
+    this->m_dirty = 0;
+    ++this->m_committedUpdates;
+
+    if (dirty & DirtyPalette) {
         auto palette = this->palette();
-        palette.setColor(QPalette::Window, this->m_inactiveColor);
+        palette.setColor(QPalette::Window, this->backgroundColor());
         this->setPalette(palette);
+        Instrumentation::count(&this->m_counters,
+                               Instrumentation::PalettePropagations);
+    }
+    if (dirty & DirtyMinimize) {
+        this->updatePart(TitleBarButton::Minimize);
     }
+    if (dirty & DirtyMaximizeRestore) {
+        this->updatePart(TitleBarButton::MaximizeRestore);
+    }
+    if (dirty & DirtyClose) {
+        this->updatePart(TitleBarButton::Close);
+    }
+}
 
-    auto iconsPaths =
-        Internal::captionIconPathsForState(this->m_active,
-                                           this->m_maximized,
-                                           false,
-                                           false,
-                                           this->m_captionButtonStyle);
+bool TitleBar::isActive() const {
+    return this->m_active;
+}
 
-    this->m_buttonMinimize->setIcon(QIcon(iconsPaths[0].toString()));
-    this->m_buttonMaximizeRestore->setIcon(QIcon(iconsPaths[1].toString()));
-    this->m_buttonClose->setIcon(QIcon(iconsPaths[2].toString()));
+void TitleBar::setActive(bool active) {
+    this->applyState(TitleBarState{active, this->m_maximized});
 }
 
 bool TitleBar::isMaximized() const {
@@ -332,25 +729,29 @@ bool TitleBar::isMaximized() const {
 }
 
 void TitleBar::setMaximized(bool maximized) {
-    this->m_maximized = maximized;
-    auto iconsPaths =
-        Internal::captionIconPathsForState(this->m_active,
-                                           this->m_maximized,
-                                           false,
-                                           false,
-                                           this->m_captionButtonStyle);
-
-    this->m_buttonMinimize->setIcon(QIcon(iconsPaths[0].toString()));
-    this->m_buttonMaximizeRestore->setIcon(QIcon(iconsPaths[1].toString()));
-    this->m_buttonClose->setIcon(QIcon(iconsPaths[2].toString()));
+    this->applyState(TitleBarState{this->m_active, maximized});
 }
 
 void TitleBar::setMinimizable(bool on) {
-    this->m_buttonMinimize->setVisible(on);
+    this->endLiveResize();
+    this->m_minimizable = on;
+    if (this->m_mode == TitleBarMode::Painted) {
+        this->layoutParts();
+        this->update();
+    } else {
+        this->m_buttonMinimize->setVisible(on);
+    }
 }
 
 void TitleBar::setMaximizable(bool on) {
-    this->m_buttonMaximizeRestore->setVisible(on);
+    this->endLiveResize();
+    this->m_maximizable = on;
+    if (this->m_mode == TitleBarMode::Painted) {
+        this->layoutParts();
+        this->update();
+    } else {
+        this->m_buttonMaximizeRestore->setVisible(on);
+    }
 }
 
 QColor TitleBar::activeColor() {
@@ -358,11 +759,10 @@ QColor TitleBar::activeColor() {
 }
 
 void TitleBar::setActiveColor(const QColor &inactiveColor) {
-#ifdef _WIN32
     this->m_activeColorOverridden = true;
-#endif
     this->m_activeColor = inactiveColor;
-    this->update();
+    this->resolveTheme();
+    this->markDirty(DirtyPalette);
 }
 
 QColor TitleBar::inactiveColor() {
@@ -370,8 +770,9 @@ QColor TitleBar::inactiveColor() {
 }
 
 void TitleBar::setInactiveColor(const QColor &inactiveColor) {
-    this->m_activeColor = inactiveColor;
-    this->update();
+    this->m_inactiveColor = inactiveColor;
+    this->resolveTheme();
+    this->markDirty(DirtyPalette);
 }
 
 QColor TitleBar::hoverColor() const {
@@ -380,78 +781,409 @@ QColor TitleBar::hoverColor() const {
 
 void TitleBar::setHoverColor(QColor hoverColor) {
     this->m_hoverColor = std::move(hoverColor);
+    this->resolveTheme();
+    if (this->m_mode == TitleBarMode::Painted) {
+        this->triggerCaptionRepaint();
+        return;
+    }
     this->m_buttonMinimize->setHoverColor(this->m_hoverColor);
     this->m_buttonMaximizeRestore->setHoverColor(this->m_hoverColor);
 }
 
 CaptionButtonStyle TitleBar::captionButtonStyle() const {
+    if (this->m_theme.has_value() && this->m_theme->glyphs.has_value()) {
+        return *this->m_theme->glyphs;
+    }
     return this->m_captionButtonStyle;
 }
 
 void TitleBar::setCaptionButtonStyle(CaptionButtonStyle captionButtonStyle) {
     this->m_captionButtonStyle = captionButtonStyle;
-    
-    int pm_icon_size = style()->pixelMetric(QStyle::PM_TitleBarButtonIconSize);
-    auto iconSize = QSize(pm_icon_size, pm_icon_size);
-    int requiredWidth = style()->pixelMetric(QStyle::PM_TitleBarButtonSize);
+    this->prewarmGlyphs();
+    this->markDirty(DirtyCaptionButtons);
+}
+
+void TitleBar::setTheme(const TitleBarTheme &theme) {
+    this->m_theme = theme;
+    this->applyTheme();
+}
+
+void TitleBar::resetTheme() {
+    this->m_theme.reset();
+    this->applyTheme();
+}
+
+const TitleBarTheme *TitleBar::theme() const {
+    return this->m_theme.has_value() ? &*this->m_theme : nullptr;
+}
+
+const Internal::ResolvedTitleBarTheme *TitleBar::resolvedTheme() const {
+    return this->m_theme.has_value() ? &this->m_resolvedTheme : nullptr;
+}
+
+void TitleBar::applyTheme() {
+    this->endLiveResize();
+    // Relayout even if the theme's sizes match the current ones, the glyphs
+    // or the caption icon margin may still have changed
+    this->m_styleMetrics = Internal::StyleMetrics();
+    this->applyStyleMetrics();
+    this->m_background = QPixmap();
+    this->markDirty(DirtyPalette | DirtyCaptionButtons);
+    this->update();
+}
+
+void TitleBar::resolveTheme() {
+    if (!this->m_theme.has_value()) {
+        this->m_resolvedTheme = Internal::ResolvedTitleBarTheme();
+        return;
+    }
+    this->m_resolvedTheme = Internal::resolveTitleBarTheme(
+        *this->m_theme,
+        this->m_activeColor,
+        this->m_inactiveColor,
+        this->m_hoverColor,
+        this->m_mode == TitleBarMode::Painted
+            ? this->m_captionIcon
+            : this->m_buttonCaptionIcon->icon(),
+        this->m_styleMetrics.captionIconSize,
+        this->devicePixelRatioF());
+}
+
+QColor TitleBar::backgroundColor() const {
+    if (this->m_theme.has_value()) {
+        return this->m_active
+                   ? this->m_resolvedTheme.activeBackground.color()
+                   : this->m_resolvedTheme.inactiveBackground.color();
+    }
+    return this->m_active ? this->m_activeColor : this->m_inactiveColor;
+}
+
+int TitleBar::captionIconMarginWidth() const {
+    if (!this->m_captionIconMargin) {
+        return 0;
+    }
+    if (this->m_theme.has_value() && this->m_theme->captionIconMargin >= 0) {
+        return this->m_theme->captionIconMargin;
+    }
+    return Internal::captionLeftMargin;
+}
+
+void TitleBar::prewarmGlyphs() {
+    const int iconSize = this->m_styleMetrics.buttonIconSize;
+    Internal::GlyphCache::instance().prewarm(this->captionButtonStyle(),
+                                             QSize(iconSize, iconSize));
+}
+
+void TitleBar::applyStyleMetrics() {
+    auto metrics =
+        Internal::styleMetrics(this->style(), this->devicePixelRatioF());
+    if (this->m_theme.has_value()) {
+        metrics = Internal::themedStyleMetrics(*this->m_theme, metrics);
+    }
+    if (metrics == this->m_styleMetrics) {
+        // The scale may still have changed
+        this->resolveTheme();
+        return;
+    }
+    this->m_styleMetrics = metrics;
+    this->resolveTheme();
+    this->prewarmGlyphs();
+
+    this->setMinimumSize(QSize(0, metrics.titleBarHeight));
+    this->setMaximumSize(QSize(QWIDGETSIZE_MAX, metrics.titleBarHeight));
+    if (this->m_menuBar != nullptr) {
+        this->m_menuBar->setFixedHeight(metrics.titleBarHeight);
+    }
+    if (this->m_mode == TitleBarMode::Painted) {
+        this->layoutParts();
+        this->update();
+        return;
+    }
+    this->m_horizontalLayout->setSpacing(metrics.horizontalSpacing);
+    if (this->m_leftMargin != nullptr) {
+        const int margin = this->captionIconMarginWidth();
+        this->m_leftMargin->setMinimumSize(QSize(margin, 0));
+        this->m_leftMargin->setMaximumSize(QSize(margin, QWIDGETSIZE_MAX));
+    }
+
+    const auto buttonSize = QSize(metrics.buttonSize, metrics.buttonSize);
+    const auto iconSize =
+        QSize(metrics.buttonIconSize, metrics.buttonIconSize);
+    this->m_buttonCaptionIcon->setMinimumSize(buttonSize);
+    this->m_buttonCaptionIcon->setMaximumSize(buttonSize);
+    this->m_buttonCaptionIcon->setIconSize(
+        QSize(metrics.captionIconSize, metrics.captionIconSize));
+    this->m_buttonMinimize->setMinimumSize(buttonSize);
+    this->m_buttonMinimize->setMaximumSize(buttonSize);
     this->m_buttonMinimize->setIconSize(iconSize);
-    this->m_buttonMinimize->setMinimumWidth(requiredWidth);
-    this->m_buttonMinimize->setMaximumWidth(requiredWidth);
+    this->m_buttonMaximizeRestore->setMinimumSize(buttonSize);
+    this->m_buttonMaximizeRestore->setMaximumSize(buttonSize);
     this->m_buttonMaximizeRestore->setIconSize(iconSize);
-    this->m_buttonMaximizeRestore->setMinimumWidth(requiredWidth);
-    this->m_buttonMaximizeRestore->setMaximumWidth(requiredWidth);
+    this->m_buttonClose->setMinimumSize(
+        QSize(metrics.buttonSize, metrics.buttonIconSize));
+    this->m_buttonClose->setMaximumSize(
+        QSize(metrics.buttonSize, metrics.buttonIconSize));
     this->m_buttonClose->setIconSize(iconSize);
-    this->m_buttonClose->setMinimumWidth(requiredWidth);
-    this->m_buttonClose->setMaximumWidth(requiredWidth);
+}
+
+void TitleBar::onAccentColorChange(const QColor &color) {
+    if (this->m_activeColorOverridden || color == this->m_activeColor) {
+        return;
+    }
+    this->m_activeColor = color;
+    this->resolveTheme();
+    this->markDirty(DirtyPalette);
+}
 
-    auto iconsPaths =
-        Internal::captionIconPathsForState(this->m_active,
-                                           this->m_maximized,
-                                           false,
-                                           false,
-                                           this->m_captionButtonStyle);
+MoveStrategy TitleBar::moveStrategy() const {
+    return this->m_moveStrategy;
+}
 
-    this->m_buttonMinimize->setIcon(QIcon(iconsPaths[0].toString()));
-    this->m_buttonMaximizeRestore->setIcon(QIcon(iconsPaths[1].toString()));
-    this->m_buttonClose->setIcon(QIcon(iconsPaths[2].toString()));
+void TitleBar::setMoveStrategy(MoveStrategy moveStrategy) {
+    this->m_moveStrategy = moveStrategy;
 }
 
 void TitleBar::onWindowStateChange(Qt::WindowStates state) {
-    this->setActive(this->window()->isActiveWindow());
-    this->setMaximized(static_cast<bool>(state & Qt::WindowMaximized));
+    // Full screen changes resize the window as well
+    this->m_stateChangeResizePending = true;
+    this->applyState(
+        TitleBarState{this->window()->isActiveWindow(),
+                      static_cast<bool>(state & Qt::WindowMaximized)});
 }
 
-bool TitleBar::hovered() const {
-    auto cursorPos = QCursor::pos();
-    bool hovered = this->rect().contains(this->mapFromGlobal(cursorPos));
-    if (!hovered) {
-        return false;
+void TitleBar::setDraggable(QWidget *widget, bool draggable) {
+    auto it = std::find(std::begin(this->m_nonDraggableWidgets),
+                        std::end(this->m_nonDraggableWidgets),
+                        widget);
+    const bool listed = it != std::end(this->m_nonDraggableWidgets);
+    if (draggable == !listed) {
+        return;
+    }
+    if (draggable) {
+        this->m_nonDraggableWidgets.erase(it);
+        widget->removeEventFilter(this);
+    } else {
+        this->m_nonDraggableWidgets.emplace_back(widget);
+        widget->installEventFilter(this);
     }
+    this->invalidateDragIndex();
+}
+
+bool TitleBar::isDraggable(QWidget *widget) const {
+    return std::find(std::begin(this->m_nonDraggableWidgets),
+                     std::end(this->m_nonDraggableWidgets),
+                     widget) == std::end(this->m_nonDraggableWidgets);
+}
 
-    if (this->m_menuBar->rect().contains(
-            this->m_menuBar->mapFromGlobal(cursorPos))) {
+bool TitleBar::isDragArea(const QPoint &pos) const {
+    if (!this->rect().contains(pos)) {
         return false;
     }
+    if (!this->m_dragIndexValid) {
+        const_cast<TitleBar *>(this)->rebuildDragIndex();
+    }
 
-    for (const TitleBarButton *btn : this->findChildren<TitleBarButton *>()) {
-        bool btnHovered = btn->rect().contains(btn->mapFromGlobal(cursorPos));
-        if (btnHovered) {
+    const auto &rects = this->m_dragExclusionRects;
+    auto it = std::upper_bound(
+        std::begin(rects),
+        std::end(rects),
+        pos.x(),
+        [](int x, const QRect &rect) { return x < rect.left(); });
+    auto index = std::distance(std::begin(rects), it) - 1;
+    for (; index >= 0; --index) {
+        const auto i = static_cast<std::size_t>(index);
+        if (this->m_dragExclusionMaxRight[i] < pos.x()) {
+            break;
+        }
+        if (rects[i].contains(pos)) {
             return false;
         }
     }
     return true;
 }
 
+void TitleBar::invalidateDragIndex() {
+    this->m_dragIndexValid = false;
+}
+
+void TitleBar::rebuildDragIndex() {
+    this->m_dragExclusionRects.clear();
+    for (const auto &widget : this->m_nonDraggableWidgets) {
+        if (widget.isNull() || !widget->isVisibleTo(this)) {
+            continue;
+        }
+        this->m_dragExclusionRects.emplace_back(
+            widget->mapTo(this, QPoint(0, 0)), widget->size());
+    }
+    for (const auto &rect : this->m_captionLayout.parts) {
+        if (!rect.isNull()) {
+            this->m_dragExclusionRects.push_back(rect);
+        }
+    }
+    // The caption buttons are hidden while their snapshot stands in for
+    // them, presses on it must not start a move either
+    if (this->m_liveResizing && !this->m_liveResizeButtons.isNull()) {
+        this->m_dragExclusionRects.push_back(this->liveResizeButtonsRect());
+    }
+    std::sort(std::begin(this->m_dragExclusionRects),
+              std::end(this->m_dragExclusionRects),
+              [](const QRect &a, const QRect &b) {
+                  return a.left() < b.left();
+              });
+
+    this->m_dragExclusionMaxRight.clear();
+    int maxRight = std::numeric_limits<int>::min();
+    for (const auto &rect : this->m_dragExclusionRects) {
+        maxRight = std::max(maxRight, rect.right());
+        this->m_dragExclusionMaxRight.push_back(maxRight);
+    }
+    this->m_dragIndexValid = true;
+}
+
+bool TitleBar::event(QEvent *event) {
+    switch (event->type()) {
+    case QEvent::LayoutRequest:
+        this->invalidateDragIndex();
+        break;
+    case QEvent::Resize: {
+        this->invalidateDragIndex();
+        if (this->m_mode == TitleBarMode::Painted) {
+            this->layoutParts();
+            break;
+        }
+        const auto oldSize = static_cast<QResizeEvent *>(event)->oldSize();
+        if (this->isVisible() && oldSize.isValid()) {
+            this->onResizeStep(oldSize);
+        }
+        break;
+    }
+    case QEvent::LayoutDirectionChange:
+        if (this->m_mode == TitleBarMode::Painted) {
+            this->layoutParts();
+        }
+        break;
+    case QEvent::Enter:
+        this->m_dragAreaHovered =
+            this->isDragArea(static_cast<QEnterEvent *>(event)->pos());
+        break;
+    case QEvent::Leave:
+        this->m_dragAreaHovered = false;
+        this->setHoveredPart(Internal::CaptionButtonStates::none);
+        break;
+    case QEvent::Hide:
+        this->m_dragAreaHovered = false;
+        this->endLiveResize();
+        this->setHoveredPart(Internal::CaptionButtonStates::none);
+        this->m_captionButtonStates.reset();
+        break;
+    case QEvent::StyleChange:
+        this->m_background = QPixmap();
+        Internal::invalidateStyleMetrics(this->style());
+        this->applyStyleMetrics();
+        break;
+    case QEvent::Show:
+        this->watchScreenChanges();
+        break;
+    case QEvent::ApplicationPaletteChange:
+        Internal::ThemeWatcher::instance().scheduleRefresh();
+        break;
+    default:
+        break;
+    }
+    return QWidget::event(event);
+}
+
+void TitleBar::watchScreenChanges() {
+    QWindow *windowHandle = this->window()->windowHandle();
+    if (windowHandle == nullptr || windowHandle == this->m_watchedWindow) {
+        return;
+    }
+    if (!this->m_watchedWindow.isNull()) {
+        disconnect(this->m_watchedWindow, nullptr, this, nullptr);
+    }
+    this->m_watchedWindow = windowHandle;
+    connect(windowHandle, &QWindow::screenChanged, this, [this]() {
+        this->applyStyleMetrics();
+        this->prewarmGlyphs();
+    });
+    this->applyStyleMetrics();
+}
+
+bool TitleBar::eventFilter(QObject *watched, QEvent *event) {
+    switch (event->type()) {
+    case QEvent::Move:
+    case QEvent::Resize:
+    case QEvent::Show:
+    case QEvent::Hide:
+    case QEvent::ParentChange:
+        this->invalidateDragIndex();
+        break;
+    case QEvent::Paint:
+        this->m_paintedArea +=
+            regionArea(static_cast<QPaintEvent *>(event)->region());
+        break;
+    // The title bar sees no events while the pointer is over one of these,
+    // leaving one returns it to the title bar or is followed by its Leave
+    case QEvent::Enter:
+        this->m_dragAreaHovered = false;
+        break;
+    case QEvent::Leave:
+        this->m_dragAreaHovered = true;
+        break;
+    default:
+        break;
+    }
+    return QWidget::eventFilter(watched, event);
+}
+
+bool TitleBar::hovered() const {
+    return this->m_dragAreaHovered;
+}
+
 bool TitleBar::isCaptionButtonHovered() const {
+    if (this->m_mode == TitleBarMode::Painted) {
+        return this->m_captionButtonStates.hovered() !=
+               Internal::CaptionButtonStates::none;
+    }
     return this->m_buttonMinimize->underMouse() ||
            this->m_buttonMaximizeRestore->underMouse() ||
            this->m_buttonClose->underMouse();
 }
 
 void TitleBar::triggerCaptionRepaint() {
-    this->m_buttonMinimize->update();
-    this->m_buttonMaximizeRestore->update();
-    this->m_buttonClose->update();
+    this->updatePart(TitleBarButton::Minimize);
+    this->updatePart(TitleBarButton::MaximizeRestore);
+    this->updatePart(TitleBarButton::Close);
+}
+
+void TitleBar::onCaptionButtonHoverChanged(TitleBarButton *button) {
+    // On mac style, all caption buttons get the 'hovered' style if any of
+    // them is hovered. Otherwise only the button itself changes, and
+    // QPushButton already repaints it for WA_Hover.
+    if (this->captionButtonStyle() == CaptionButtonStyle::mac &&
+        button->role() != TitleBarButton::CaptionIcon) {
+        this->triggerCaptionRepaint();
+    }
+}
+
+quint64 TitleBar::paintedArea() const {
+    return this->m_paintedArea;
+}
+
+void TitleBar::resetPaintedArea() {
+    this->m_paintedArea = 0;
+}
+
+const Instrumentation::Counters &TitleBar::counters() const {
+    return this->m_counters;
+}
+
+Instrumentation::Counters &TitleBar::counters() {
+    return this->m_counters;
+}
+
+void TitleBar::fadeCaptionButton(TitleBarButton *button, double target) {
+    this->m_fadeDriver->fadeTo(button, target);
 }
 
 namespace Internal {
@@ -461,106 +1193,8 @@ std::array<QStringView, 3> captionIconPathsForState(bool active,
                                                     bool hovered,
                                                     bool pressed,
                                                     CaptionButtonStyle style) {
-    std::array<QStringView, 3> buf;
-
-    switch (style) {
-    case CaptionButtonStyle::custom: {
-        if (active || hovered) {
-            buf[0] = u":/resources/titlebar/custom/chrome-minimize-dark.svg";
-            if (maximized) {
-                buf[1] =
-                    u":/resources/titlebar/custom/chrome-restore-dark.svg";
-            } else {
-                buf[1] =
-                    u":/resources/titlebar/custom/chrome-maximize-dark.svg";
-            }
-            if (hovered) {
-                buf[2] = u":/resources/titlebar/custom/chrome-close-light.svg";
-            } else {
-                buf[2] = u":/resources/titlebar/custom/chrome-close-dark.svg";
-            }
-        } else {
-            buf[0] = u":/resources/titlebar/custom/"
-                     u"chrome-minimize-dark-disabled.svg";
-            if (maximized) {
-                buf[1] = u":/resources/titlebar/custom/"
-                         u"chrome-restore-dark-disabled.svg";
-            } else {
-                buf[1] = u":/resources/titlebar/custom/"
-                         u"chrome-maximize-dark-disabled.svg";
-            }
-            buf[2] =
-                u":/resources/titlebar/custom/chrome-close-dark-disabled.svg";
-        }
-        break;
-    }
-    case CaptionButtonStyle::win: {
-        if (active || hovered) {
-            buf[0] = u":/resources/titlebar/win/chrome-minimize-dark.svg";
-            if (maximized) {
-                buf[1] = u":/resources/titlebar/win/chrome-restore-dark.svg";
-            } else {
-                buf[1] = u":/resources/titlebar/win/chrome-maximize-dark.svg";
-            }
-            if (hovered) {
-                buf[2] = u":/resources/titlebar/win/chrome-close-light.svg";
-            } else {
-                buf[2] = u":/resources/titlebar/win/chrome-close-dark.svg";
-            }
-        } else {
-            buf[0] =
-                u":/resources/titlebar/win/chrome-minimize-dark-disabled.svg";
-            if (maximized) {
-                buf[1] = u":/resources/titlebar/win/"
-                         u"chrome-restore-dark-disabled.svg";
-            } else {
-                buf[1] = u":/resources/titlebar/win/"
-                         u"chrome-maximize-dark-disabled.svg";
-            }
-            buf[2] =
-                u":/resources/titlebar/win/chrome-close-dark-disabled.svg";
-        }
-        break;
-    }
-    case CaptionButtonStyle::mac: {
-        if (pressed) {
-            buf[0] = u":/resources/titlebar/mac/minimize-pressed.png";
-            if (maximized) {
-                buf[1] = u":/resources/titlebar/mac/"
-                         "maximize-restore-maximized-pressed.png";
-            } else {
-                buf[1] = u":/resources/titlebar/mac/"
-                         u"maximize-restore-normal-pressed.png";
-            }
-            buf[2] = u":/resources/titlebar/mac/close-pressed.png";
-        } else {
-            if (hovered) {
-                buf[0] = u":/resources/titlebar/mac/minimize-hovered.png";
-                if (maximized) {
-                    buf[1] = u":/resources/titlebar/mac/"
-                             u"maximize-restore-maximized-hovered.png";
-                } else {
-                    buf[1] = u":/resources/titlebar/mac/"
-                             u"maximize-restore-normal-hovered.png";
-                }
-                buf[2] = u":/resources/titlebar/mac/close-hovered.png";
-            } else {
-                if (active) {
-                    buf[0] = u":/resources/titlebar/mac/minimize.png";
-                    buf[1] = u":/resources/titlebar/mac/maximize-restore.png";
-                    buf[2] = u":/resources/titlebar/mac/close.png";
-                } else {
-                    buf[0] = u":/resources/titlebar/mac/inactive.png";
-                    buf[1] = u":/resources/titlebar/mac/inactive.png";
-                    buf[2] = u":/resources/titlebar/mac/inactive.png";
-                }
-            }
-        }
-        break;
-    }
-    }
-
-    return buf;
+    return captionStateTable[captionStateIndex(
+        active, maximized, hovered, pressed, style)];
 }
 
 } // namespace Internal
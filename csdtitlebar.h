@@ -1,28 +1,57 @@
 #pragma once
 
 #include "captionbuttonstyle.h"
+#include "csdcaptionbuttons.h"
+#include "csdinstrumentation.h"
+#include "csdstylemetrics.h"
+#include "csdtitlebarbutton.h"
+#include "csdtitlebartheme.h"
 
 #include <QPalette>
+#include <QBasicTimer>
 #include <QColor>
 #include <QIcon>
+#include <QPixmap>
+#include <QPointer>
+#include <QRect>
 #include <QStringView>
 #include <QWidget>
 
 #include <array>
+#include <cstddef>
 #include <optional>
+#include <vector>
 
 class QHBoxLayout;
 class QLayout;
 class QLabel;
 class QMenuBar;
-
-#ifdef _WIN32
-class QRegistryWatcher;
-#endif
+class QPainter;
+class QWindow;
 
 namespace CSD {
 
-class TitleBarButton;
+namespace Internal {
+class ClientMove;
+class FadeDriver;
+class MenuBarArea;
+}
+
+struct TitleBarState {
+    bool active = false;
+    bool maximized = false;
+};
+
+// How dragging the title bar moves the window on X11. Automatic asks the
+// window manager when it advertises _NET_WM_MOVERESIZE and moves the window
+// itself otherwise.
+enum class MoveStrategy { Automatic, WindowManager, ClientSide };
+
+// Widgets builds the caption icon and buttons from child widgets in a layout.
+// Painted draws them in the title bar's own paintEvent and hit tests and
+// tracks hover itself, which saves eight QObjects per window and the enter,
+// leave, hover and palette events they would receive.
+enum class TitleBarMode { Widgets, Painted };
 
 class TitleBar : public QWidget {
     Q_OBJECT
@@ -30,37 +59,137 @@ class TitleBar : public QWidget {
     Q_PROPERTY(bool maximized READ isMaximized WRITE setMaximized)
 
 private:
-#ifdef _WIN32
     bool m_activeColorOverridden = false;
-    QRegistryWatcher *m_watcher = nullptr;
-    std::optional<QColor> readDWMColorizationColor();
-#endif
     bool m_active = false;
     bool m_maximized = false;
     QColor m_activeColor = palette().color(QPalette::Active, QPalette::Window); // was Qt::black;
     QColor m_inactiveColor = Qt::white;
     QColor m_hoverColor = Qt::gray;
-    QHBoxLayout *m_horizontalLayout;
-    QMenuBar *m_menuBar;
-    QWidget *m_leftMargin;
+    QHBoxLayout *m_horizontalLayout = nullptr;
+    QMenuBar *m_menuBar = nullptr;
+    Internal::MenuBarArea *m_menuBarArea = nullptr;
+    QWidget *m_leftMargin = nullptr;
+    bool m_captionIconMargin = true;
     CaptionButtonStyle m_captionButtonStyle;
-    TitleBarButton *m_buttonCaptionIcon;
-    TitleBarButton *m_buttonMinimize;
-    TitleBarButton *m_buttonMaximizeRestore;
-    TitleBarButton *m_buttonClose;
+    TitleBarMode m_mode;
+    TitleBarButton *m_buttonCaptionIcon = nullptr;
+    TitleBarButton *m_buttonMinimize = nullptr;
+    TitleBarButton *m_buttonMaximizeRestore = nullptr;
+    TitleBarButton *m_buttonClose = nullptr;
+    Internal::FadeDriver *m_fadeDriver = nullptr;
+    void createCaptionWidgets(const QIcon &captionIcon, bool leftMargin);
 
-protected:
+    // Painted mode
+    Internal::CaptionLayout m_captionLayout;
+    Internal::CaptionButtonStates m_captionButtonStates;
+    QIcon m_captionIcon;
+    bool m_minimizable = true;
+    bool m_maximizable = true;
+    void layoutParts();
+    int partAt(const QPoint &pos) const;
+    void setHoveredPart(int part);
+    void updatePart(TitleBarButton::Role role);
+    void paintParts(QPainter &painter);
+    QColor hoverFill(TitleBarButton::Role role) const;
+
+    std::optional<TitleBarTheme> m_theme;
+    Internal::ResolvedTitleBarTheme m_resolvedTheme;
+    void applyTheme();
+    void resolveTheme();
+    QColor backgroundColor() const;
+    int captionIconMarginWidth() const;
+
+    enum DirtyFlag : int {
+        DirtyPalette = 1 << 0,
+        DirtyMinimize = 1 << 1,
+        DirtyMaximizeRestore = 1 << 2,
+        DirtyClose = 1 << 3,
+        DirtyCaptionButtons =
+            DirtyMinimize | DirtyMaximizeRestore | DirtyClose,
+    };
+    int m_dirty = 0;
+    quint64 m_committedUpdates = 0;
+    quint64 m_droppedUpdates = 0;
+    void markDirty(int flags);
+    void commitPendingUpdates();
+
+    // Widgets that swallow presses instead of dragging the window, and their
+    // rects in title bar coordinates sorted by left edge. maxRight[i] is the
+    // largest right edge of the first i + 1 rects.
+    std::vector<QPointer<QWidget>> m_nonDraggableWidgets;
+    std::vector<QRect> m_dragExclusionRects;
+    std::vector<int> m_dragExclusionMaxRight;
+    bool m_dragIndexValid = false;
+    // Whether the pointer was over a drag area at the last mouse event
+    bool m_dragAreaHovered = false;
+    void invalidateDragIndex();
+    void rebuildDragIndex();
+
+    QPixmap m_background;
+    QColor m_backgroundColor;
+    qreal m_backgroundDpr = 0.0;
+    quint64 m_paintedArea = 0;
+    bool m_firstPaintDone = false;
+    void updateBackgroundCache();
+
+    Instrumentation::Counters m_counters;
+
+    Internal::StyleMetrics m_styleMetrics;
+    QPointer<QWindow> m_watchedWindow;
+    void applyStyleMetrics();
+    void prewarmGlyphs();
+    void watchScreenChanges();
+
+    // Interactive resizing. From the first resize step until resizing goes
+    // idle the layout is suspended, hover fades are frozen and the caption
+    // buttons are drawn from a snapshot anchored to their edge. The resize
+    // that follows a window state change is laid out as usual, and a state
+    // change during live resizing ends it.
+    static constexpr int liveResizeIdleMs = 150;
+    bool m_liveResizeEnabled = true;
+    bool m_liveResizing = false;
+    bool m_stateChangeResizePending = false;
+    QBasicTimer m_liveResizeTimer;
+    QPixmap m_liveResizeButtons;
+    int m_liveResizeButtonsOffset = 0;
+    int m_liveResizeButtonsTop = 0;
+    std::vector<TitleBarButton *> m_liveResizeHiddenButtons;
+    QRect liveResizeButtonsRect() const;
+    void onResizeStep(const QSize &oldSize);
+    void beginLiveResize();
+    void endLiveResize();
+
+    MoveStrategy m_moveStrategy = MoveStrategy::Automatic;
 #if !defined(_WIN32) && !defined(__APPLE__)
-    void mousePressEvent(QMouseEvent *event) override;
+    Internal::ClientMove *m_clientMove = nullptr;
 #endif
+
+protected:
+    void mousePressEvent(QMouseEvent *event) override;
+    void mouseMoveEvent(QMouseEvent *event) override;
+    void mouseReleaseEvent(QMouseEvent *event) override;
     void paintEvent(QPaintEvent *event) override;
+    bool event(QEvent *event) override;
+    bool eventFilter(QObject *watched, QEvent *event) override;
+    void timerEvent(QTimerEvent *event) override;
 
 public:
     explicit TitleBar(CaptionButtonStyle captionButtonStyle,
                       const QIcon &captionIcon = QIcon(),
-                      QWidget *parent = nullptr);
+                      QWidget *parent = nullptr,
+                      TitleBarMode mode = TitleBarMode::Widgets);
     ~TitleBar() override;
 
+    TitleBarMode mode() const;
+
+    TitleBarState state() const;
+    void applyState(const TitleBarState &state);
+    quint64 committedUpdateCount() const;
+    quint64 droppedUpdateCount() const;
+    bool isLiveResizing() const;
+    bool isLiveResizeEnabled() const;
+    void setLiveResizeEnabled(bool enabled);
+
     bool isActive() const;
     void setActive(bool active);
     bool isMaximized() const;
@@ -75,11 +204,38 @@ public:
     void setHoverColor(QColor hoverColor);
     CaptionButtonStyle captionButtonStyle() const;
     void setCaptionButtonStyle(CaptionButtonStyle captionButtonStyle);
+
+    // Paints with the theme's resolved brushes and pixmaps instead of going
+    // through the widget style. Its colors, glyphs and sizes take precedence
+    // over the ones set individually.
+    void setTheme(const TitleBarTheme &theme);
+    void resetTheme();
+    // Null unless a theme is set
+    const TitleBarTheme *theme() const;
+    const Internal::ResolvedTitleBarTheme *resolvedTheme() const;
+    MoveStrategy moveStrategy() const;
+    void setMoveStrategy(MoveStrategy moveStrategy);
     void onWindowStateChange(Qt::WindowStates state);
+    void onAccentColorChange(const QColor &color);
+    void setDraggable(QWidget *widget, bool draggable);
+    bool isDraggable(QWidget *widget) const;
+    bool isDragArea(const QPoint &pos) const;
     bool hovered() const;
 
     bool isCaptionButtonHovered() const;
     void triggerCaptionRepaint();
+    void onCaptionButtonHoverChanged(TitleBarButton *button);
+
+    // Area in device independent pixels repainted by the title bar and its
+    // non-draggable children since the last reset
+    quint64 paintedArea() const;
+    void resetPaintedArea();
+
+    // Per title bar performance counters, all zero unless the library is
+    // built with CSD_INSTRUMENTATION
+    const Instrumentation::Counters &counters() const;
+    Instrumentation::Counters &counters();
+    void fadeCaptionButton(TitleBarButton *button, double target);
 
 signals:
     void minimizeClicked();
@@ -89,6 +245,20 @@ signals:
 
 namespace Internal {
 
+// Packs a caption state into an index of the generated caption state table:
+// bit 0 pressed, bit 1 hovered, bit 2 maximized, bit 3 active, bits 4-5 style.
+constexpr std::size_t captionStateIndex(bool active,
+                                        bool maximized,
+                                        bool hovered,
+                                        bool pressed,
+                                        CaptionButtonStyle style) {
+    return (static_cast<std::size_t>(style) << 4) |
+           (static_cast<std::size_t>(active) << 3) |
+           (static_cast<std::size_t>(maximized) << 2) |
+           (static_cast<std::size_t>(hovered) << 1) |
+           static_cast<std::size_t>(pressed);
+}
+
 std::array<QStringView, 3> captionIconPathsForState(bool active,
                                                     bool maximized,
                                                     bool hovered,
@@ -1,9 +1,10 @@
 #include "csdtitlebarbutton.h"
 
+#include "csdglyphcache.h"
 #include "csdtitlebar.h"
 
 #include <QEvent>
-#include <QPropertyAnimation>
+#include <QPainter>
 #include <QStyleOption>
 #include <QStylePainter>
 
@@ -25,6 +26,14 @@ TitleBarButton::TitleBarButton(const QIcon &icon,
     this->setAttribute(Qt::WidgetAttribute::WA_Hover, true);
 }
 
+QColor TitleBarButton::closeHoverColor() {
+    return QColor(232, 17, 35, 229);
+}
+
+TitleBarButton::Role TitleBarButton::role() const {
+    return this->m_role;
+}
+
 double TitleBarButton::fader() const {
     return this->m_fader;
 }
@@ -57,17 +66,11 @@ bool TitleBarButton::event(QEvent *event) {
     }
     switch (event->type()) {
     case QEvent::Enter: {
-        auto animation = new QPropertyAnimation(this, "fader");
-        animation->setDuration(125);
-        animation->setEndValue(1.0);
-        animation->start(QAbstractAnimation::DeleteWhenStopped);
+        static_cast<TitleBar *>(this->parent())->fadeCaptionButton(this, 1.0);
         break;
     }
     case QEvent::Leave: {
-        auto animation = new QPropertyAnimation(this, "fader");
-        animation->setDuration(125);
-        animation->setEndValue(0.0);
-        animation->start(QAbstractAnimation::DeleteWhenStopped);
+        static_cast<TitleBar *>(this->parent())->fadeCaptionButton(this, 0.0);
         break;
     }
     default:
@@ -78,6 +81,14 @@ bool TitleBarButton::event(QEvent *event) {
 
 void TitleBarButton::paintEvent([[maybe_unused]] QPaintEvent *event) {
     auto *titleBar = static_cast<TitleBar *>(this->parent());
+    Instrumentation::count(&titleBar->counters(),
+                           Instrumentation::ButtonPaints);
+    const auto timer = Instrumentation::ScopedTimer(
+        &titleBar->counters(), Instrumentation::ButtonPaintNs);
+    if (const auto *theme = titleBar->resolvedTheme()) {
+        this->paintThemed(*theme);
+        return;
+    }
 
     auto stylePainter = QStylePainter(this);
     auto styleOptionButton = QStyleOptionButton();
@@ -88,7 +99,7 @@ void TitleBarButton::paintEvent([[maybe_unused]] QPaintEvent *event) {
     styleOptionButton.iconSize = this->iconSize();
 
     const auto hoverColor = [titleBar, this]() -> QColor {
-        auto col = this->m_role == Role::Close ? QColor(232, 17, 35, 229)
+        auto col = this->m_role == Role::Close ? closeHoverColor()
                                                : this->m_hoverColor;
         if (!this->m_keepDown) {
             col.setAlpha(static_cast<int>(this->m_fader * col.alpha()));
@@ -116,52 +127,102 @@ void TitleBarButton::paintEvent([[maybe_unused]] QPaintEvent *event) {
         (titleBar->captionButtonStyle() == CaptionButtonStyle::mac &&
          titleBar->isCaptionButtonHovered());
 
-    const auto iconPaths =
-        Internal::captionIconPathsForState(titleBar->isActive(),
-                                           titleBar->isMaximized(),
-                                           isHovered,
-                                           this->isDown(),
-                                           titleBar->captionButtonStyle());
+    stylePainter.setRenderHint(QPainter::Antialiasing, false);
+    stylePainter.setPen(Qt::NoPen);
+    stylePainter.setBrush(QBrush(hoverColor));
+    stylePainter.drawRect(styleOptionButton.rect);
 
-    switch (this->m_role) {
-    case Role::CaptionIcon: {
-        break;
+    if (this->m_role == Role::CaptionIcon) {
+        stylePainter.drawControl(QStyle::CE_PushButtonLabel,
+                                 styleOptionButton);
+        return;
     }
-    case Role::Minimize: {
-        if (isHovered) {
-            styleOptionButton.icon = QIcon(iconPaths[0].toString());
-        }
-        break;
-    }
-    case Role::MaximizeRestore: {
-        if (isHovered) {
-            styleOptionButton.icon = QIcon(iconPaths[1].toString());
-        }
-        break;
+
+    const auto tint = Internal::captionGlyphTint(
+        titleBar->captionButtonStyle(),
+        this->m_role,
+        titleBar->isActive(),
+        isHovered,
+        titleBar->palette().color(QPalette::Window),
+        this->m_role == Role::Close ? closeHoverColor() : this->m_hoverColor);
+    Internal::drawCaptionGlyph(stylePainter,
+                               styleOptionButton.rect,
+                               this->layoutDirection(),
+                               titleBar->captionButtonStyle(),
+                               this->m_role,
+                               titleBar->isActive(),
+                               titleBar->isMaximized(),
+                               isHovered,
+                               isHovered && this->isDown(),
+                               this->devicePixelRatioF(),
+                               this->iconSize(),
+                               tint);
+}
+
+// Same output as the styled path, from the title bar's resolved theme and
+// without a style option or any QStyle call
+void TitleBarButton::paintThemed(
+    const Internal::ResolvedTitleBarTheme &theme) {
+    auto *titleBar = static_cast<TitleBar *>(this->parent());
+    auto painter = QPainter(this);
+    const auto rect = this->rect();
+    if (this->m_role == Role::CaptionIcon) {
+        const auto &pixmap =
+            this->isEnabled() ? theme.captionIcon : theme.disabledCaptionIcon;
+        const auto iconRect =
+            QStyle::alignedRect(this->layoutDirection(),
+                                Qt::AlignCenter,
+                                pixmap.size() / pixmap.devicePixelRatio(),
+                                rect);
+        painter.drawPixmap(iconRect.topLeft(), pixmap);
+        return;
     }
-    case Role::Close: {
-        if (isHovered) {
-            styleOptionButton.icon = QIcon(iconPaths[2].toString());
+
+    const auto style = titleBar->captionButtonStyle();
+    const bool isMacCaptionStyle = style == CaptionButtonStyle::mac;
+    const bool isHovered =
+        this->underMouse() ||
+        (isMacCaptionStyle && titleBar->isCaptionButtonHovered());
+    const auto fill = this->m_role == Role::Close ? theme.closeHoverFill
+                                                  : theme.hoverFill;
+    if (this->isEnabled() && !isMacCaptionStyle) {
+        auto col = fill;
+        if (!this->m_keepDown) {
+            col.setAlpha(static_cast<int>(this->m_fader * col.alpha()));
         }
-        break;
-    }
+        painter.fillRect(rect, col);
     }
 
-    stylePainter.setRenderHint(QPainter::Antialiasing, false);
-    stylePainter.setPen(Qt::NoPen);
-    stylePainter.setBrush(QBrush(hoverColor));
-    stylePainter.drawRect(styleOptionButton.rect);
-    stylePainter.drawControl(QStyle::CE_PushButtonLabel, styleOptionButton);
+    const auto tint = Internal::captionGlyphTint(
+        style,
+        this->m_role,
+        titleBar->isActive(),
+        isHovered,
+        titleBar->isActive() ? theme.activeBackground.color()
+                             : theme.inactiveBackground.color(),
+        fill);
+    Internal::drawCaptionGlyph(painter,
+                               rect,
+                               this->layoutDirection(),
+                               style,
+                               this->m_role,
+                               titleBar->isActive(),
+                               titleBar->isMaximized(),
+                               isHovered,
+                               isHovered && this->isDown(),
+                               this->devicePixelRatioF(),
+                               this->iconSize(),
+                               tint);
 }
 
 void TitleBarButton::enterEvent(QEvent *event) {
     QPushButton::enterEvent(event);
-    static_cast<TitleBar *>(this->parent())->triggerCaptionRepaint();
+    static_cast<TitleBar *>(this->parent())->onCaptionButtonHoverChanged(this);
 }
 
 void TitleBarButton::leaveEvent(QEvent *event) {
     QPushButton::leaveEvent(event);
-    static_cast<TitleBar *>(this->parent())->triggerCaptionRepaint();
+    static_cast<TitleBar *>(this->parent())->onCaptionButtonHoverChanged(this);
 }
 
 } // namespace CSD
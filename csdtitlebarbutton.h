@@ -6,6 +6,10 @@ namespace CSD {
 
 class TitleBar;
 
+namespace Internal {
+struct ResolvedTitleBarTheme;
+}
+
 class TitleBarButton : public QPushButton {
     Q_OBJECT
     Q_PROPERTY(double fader READ fader WRITE setFader)
@@ -24,6 +28,10 @@ public:
                             Role role,
                             TitleBar *parent = nullptr);
 
+    // Hover fill of the close button, whatever the title bar's hover color
+    static QColor closeHoverColor();
+
+    Role role() const;
     double fader() const;
     void setFader(double value);
     QColor hoverColor() const;
@@ -38,6 +46,8 @@ protected:
     void leaveEvent(QEvent *event) override;
 
 private:
+    void paintThemed(const Internal::ResolvedTitleBarTheme &theme);
+
     Role m_role;
     double m_fader = 0.0;
     QColor m_hoverColor = Qt::gray;
@@ -0,0 +1,68 @@
+#include "csdtitlebartheme.h"
+
+#include "csdtitlebarbutton.h"
+
+namespace CSD::Internal {
+
+static QColor themeColor(const QColor &themed, const QColor &fallback) {
+    return themed.isValid() ? themed : fallback;
+}
+
+static QPixmap iconPixmap(const QIcon &icon,
+                          int size,
+                          qreal devicePixelRatio,
+                          QIcon::Mode mode) {
+    if (icon.isNull() || size <= 0) {
+        return QPixmap();
+    }
+    auto pixmap = icon.pixmap(QSize(size, size) * devicePixelRatio, mode);
+    pixmap.setDevicePixelRatio(devicePixelRatio);
+    return pixmap;
+}
+
+StyleMetrics themedStyleMetrics(const TitleBarTheme &theme,
+                                const StyleMetrics &styleMetrics) {
+    const auto themeSize = [](int themed, int fallback) {
+        return themed >= 0 ? themed : fallback;
+    };
+    auto metrics = styleMetrics;
+    metrics.titleBarHeight =
+        themeSize(theme.titleBarHeight, metrics.titleBarHeight);
+    metrics.buttonSize = themeSize(theme.buttonSize, metrics.buttonSize);
+    metrics.buttonIconSize =
+        themeSize(theme.buttonIconSize, metrics.buttonIconSize);
+    metrics.captionIconSize =
+        themeSize(theme.captionIconSize, metrics.captionIconSize);
+    metrics.horizontalSpacing =
+        themeSize(theme.buttonSpacing, metrics.horizontalSpacing);
+    return metrics;
+}
+
+ResolvedTitleBarTheme resolveTitleBarTheme(const TitleBarTheme &theme,
+                                           const QColor &activeColor,
+                                           const QColor &inactiveColor,
+                                           const QColor &hoverColor,
+                                           const QIcon &captionIcon,
+                                           int captionIconSize,
+                                           qreal devicePixelRatio) {
+    const auto hoverFill = [&theme](QColor color) {
+        color.setAlphaF(color.alphaF() * qBound(0.0, theme.hoverAlpha, 1.0));
+        return color;
+    };
+
+    auto resolved = ResolvedTitleBarTheme();
+    resolved.activeBackground =
+        QBrush(themeColor(theme.activeColor, activeColor));
+    resolved.inactiveBackground =
+        QBrush(themeColor(theme.inactiveColor, inactiveColor));
+    resolved.hoverFill = hoverFill(themeColor(theme.hoverColor, hoverColor));
+    resolved.closeHoverFill = hoverFill(themeColor(
+        theme.closeHoverColor, TitleBarButton::closeHoverColor()));
+    resolved.captionIcon = iconPixmap(
+        captionIcon, captionIconSize, devicePixelRatio, QIcon::Normal);
+    resolved.disabledCaptionIcon = iconPixmap(
+        captionIcon, captionIconSize, devicePixelRatio, QIcon::Disabled);
+    return resolved;
+}
+
+} // namespace CSD::Internal
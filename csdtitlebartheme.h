@@ -0,0 +1,67 @@
+#pragma once
+
+#include "captionbuttonstyle.h"
+#include "csdstylemetrics.h"
+
+#include <QBrush>
+#include <QColor>
+#include <QIcon>
+#include <QPixmap>
+
+#include <optional>
+
+namespace CSD {
+
+// Colors, glyphs and metrics a TitleBar paints with, given up front instead
+// of coming from the widget style. A themed title bar resolves them once
+// into brushes and pixmaps and never calls into its QStyle while painting,
+// which keeps painting cheap when the application sets a style sheet.
+// Invalid colors and negative sizes keep what the title bar would use
+// without a theme.
+struct TitleBarTheme {
+    QColor activeColor;
+    QColor inactiveColor;
+    QColor hoverColor;
+    QColor closeHoverColor;
+    // Opacity of the hover fills on top of the alpha of their colors
+    qreal hoverAlpha = 1.0;
+    std::optional<CaptionButtonStyle> glyphs;
+
+    // Logical pixels
+    int titleBarHeight = -1;
+    int buttonSize = -1;
+    int buttonIconSize = -1;
+    int captionIconSize = -1;
+    int buttonSpacing = -1;
+    // Width of the margin in front of the caption icon, if the title bar
+    // has one
+    int captionIconMargin = -1;
+};
+
+namespace Internal {
+
+// A TitleBarTheme with every fallback filled in, ready to paint with
+struct ResolvedTitleBarTheme {
+    QBrush activeBackground;
+    QBrush inactiveBackground;
+    QColor hoverFill;
+    QColor closeHoverFill;
+    QPixmap captionIcon;
+    QPixmap disabledCaptionIcon;
+};
+
+// The metrics of a title bar with the sizes the theme sets replaced
+StyleMetrics themedStyleMetrics(const TitleBarTheme &theme,
+                                const StyleMetrics &styleMetrics);
+
+ResolvedTitleBarTheme resolveTitleBarTheme(const TitleBarTheme &theme,
+                                           const QColor &activeColor,
+                                           const QColor &inactiveColor,
+                                           const QColor &hoverColor,
+                                           const QIcon &captionIcon,
+                                           int captionIconSize,
+                                           qreal devicePixelRatio);
+
+} // namespace Internal
+
+} // namespace CSD
@@ -0,0 +1,125 @@
+#include "demowindow.h"
+
+#include <QApplication>
+#include <QBoxLayout>
+#include <QCheckBox>
+#include <QMenu>
+#include <QMenuBar>
+#include <QMessageBox>
+#include <QPushButton>
+#include <QStatusBar>
+
+DemoWindow::DemoWindow(CSD::TitleBarMode titleBarMode,
+                       bool themed,
+                       QWidget *parent)
+    : QMainWindow(parent) {
+    this->setCentralWidget(new QWidget(this));
+    QMenu *fileMenu = menuBar()->addMenu("&File");
+    fileMenu->addSeparator();
+    auto *closeAct = fileMenu->addAction("&Quit", this, &QWidget::close);
+    closeAct->setStatusTip("Exit the application");
+    QMenu *aboutMenu = menuBar()->addMenu("About");
+    QAction *aboutAct = aboutMenu->addAction("&About", this, [this] {
+        QMessageBox::about(this, "About qt-csd Demo", "Qt Client Side Decorations Demo");
+    });
+    aboutAct->setStatusTip(tr("Show the application's About box"));
+    QAction *aboutQtAct = aboutMenu->addAction(tr("About &Qt"), qApp, &QApplication::aboutQt);
+    aboutQtAct->setStatusTip(tr("Show the Qt library's About box"));
+    auto *layout = new QVBoxLayout;
+    layout->setMargin(0);
+    this->centralWidget()->setLayout(layout);
+    auto *buttonToggleFullScr = new QPushButton("Toggle full screen", this);
+    connect(buttonToggleFullScr, &QPushButton::clicked, this, [this] {
+        this->setWindowState(this->windowState() ^ Qt::WindowFullScreen);
+    });
+    auto *checkBoxMinimize = new QCheckBox("Minimizable", this);
+    checkBoxMinimize->setChecked(true);
+    auto *checkBoxMaximize = new QCheckBox("Maximizable", this);
+    checkBoxMaximize->setChecked(true);
+    auto *checkBoxResize = new QCheckBox("Resizable", this);
+    checkBoxResize->setChecked(true);
+    auto *subWidget = new QWidget(this);
+    auto *outerLayout = new QVBoxLayout();
+    outerLayout->addStretch();
+    auto *centralLayout1 = new QHBoxLayout();
+    centralLayout1->addStretch();
+    centralLayout1->addWidget(checkBoxMaximize);
+    centralLayout1->addStretch();
+    outerLayout->addLayout(centralLayout1);
+    auto *centralLayout2 = new QHBoxLayout();
+    centralLayout2->addStretch();
+    centralLayout2->addWidget(checkBoxMinimize);
+    centralLayout2->addStretch();
+    outerLayout->addLayout(centralLayout2);
+    auto *centralLayout3 = new QHBoxLayout();
+    centralLayout3->addStretch();
+    centralLayout3->addWidget(checkBoxResize);
+    centralLayout3->addStretch();
+    outerLayout->addLayout(centralLayout3);
+    auto *centralLayout4 = new QHBoxLayout();
+    centralLayout4->addStretch();
+    centralLayout4->addWidget(buttonToggleFullScr);
+    centralLayout4->addStretch();
+    outerLayout->addLayout(centralLayout4);
+    outerLayout->addStretch();
+    subWidget->setLayout(outerLayout);
+    this->m_titleBar = new CSD::TitleBar(
+#ifdef _WIN32
+        CSD::CaptionButtonStyle::win,
+#else
+        CSD::CaptionButtonStyle::custom,
+#endif
+        QIcon(),
+        this,
+        titleBarMode);
+    if (themed) {
+        // The title bar's own colors and metrics, resolved once
+        this->m_titleBar->setTheme(CSD::TitleBarTheme());
+    }
+    connect(checkBoxMinimize, &QCheckBox::toggled, this, [this](bool checked) {
+        this->m_titleBar->setMinimizable(checked);
+    });
+    connect(checkBoxMaximize, &QCheckBox::toggled, this, [this](bool checked) {
+        this->m_titleBar->setMaximizable(checked);
+    });
+    layout->addWidget(this->m_titleBar);
+    layout->addWidget(subWidget);
+    this->statusBar()->showMessage("Resize me by the grip ...");
+    connect(checkBoxResize, &QCheckBox::toggled, this, [this](bool checked){
+        this->statusBar()->setVisible(checked);
+    });
+    connect(
+        this->m_titleBar, &CSD::TitleBar::minimizeClicked, this, [this]() {
+            this->setWindowState(this->windowState() |
+                                 Qt::WindowMinimized);
+        });
+    connect(this->m_titleBar,
+            &CSD::TitleBar::maximizeRestoreClicked,
+            this,
+            [this]() {
+                this->setWindowState(this->windowState() ^
+                                     Qt::WindowMaximized);
+            });
+    connect(this->m_titleBar,
+            &CSD::TitleBar::closeClicked,
+            this,
+            &QWidget::close);
+}
+
+void decorate(DecorationFilter *filter, DemoWindow *window) {
+    filter->apply(
+        window,
+#ifdef _WIN32
+        [window](const QPoint &globalPos) {
+            auto *titleBar = window->titleBar();
+            return titleBar->isDragArea(titleBar->mapFromGlobal(globalPos));
+        },
+#endif
+        [window] {
+            const bool on = window->isActiveWindow();
+            window->titleBar()->setActive(on);
+        },
+        [window] {
+            window->titleBar()->onWindowStateChange(window->windowState());
+        });
+}
@@ -0,0 +1,34 @@
+#pragma once
+
+#include "csdtitlebar.h"
+#ifdef _WIN32
+#include "win32csd.h"
+#else
+#include "linuxcsd.h"
+#endif
+
+#include <QMainWindow>
+
+// The window shown by the demo and driven by qt-csd-stress
+class DemoWindow : public QMainWindow {
+
+public:
+    DemoWindow(CSD::TitleBarMode titleBarMode = CSD::TitleBarMode::Widgets,
+               bool themed = false,
+               QWidget *parent = nullptr);
+
+    CSD::TitleBar *titleBar() {
+        return this->m_titleBar;
+    }
+
+private:
+    CSD::TitleBar *m_titleBar;
+};
+
+#ifdef _WIN32
+using DecorationFilter = CSD::Internal::Win32ClientSideDecorationFilter;
+#else
+using DecorationFilter = CSD::Internal::LinuxClientSideDecorationFilter;
+#endif
+
+void decorate(DecorationFilter *filter, DemoWindow *window);
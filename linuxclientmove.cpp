@@ -0,0 +1,111 @@
+#include "linuxclientmove.h"
+
+#include "linuxxcb.h"
+
+#include <QScreen>
+#include <QTimerEvent>
+#include <QWindow>
+
+#include <QX11Info>
+
+#include <qpa/qplatformwindow.h>
+
+#include <cmath>
+
+namespace CSD::Internal {
+
+static int frameIntervalMs(QScreen *screen) {
+    const qreal refreshRate = screen != nullptr ? screen->refreshRate() : 0.0;
+    if (refreshRate <= 0.0) {
+        return 16;
+    }
+    return qMax(1, static_cast<int>(std::lround(1000.0 / refreshRate)));
+}
+
+ClientMove::ClientMove(Instrumentation::Counters *counters, QObject *parent)
+    : QObject(parent), m_counters(counters) {
+    this->m_clock.start();
+}
+
+void ClientMove::start(QWindow *window, const QPoint &nativeGlobalPos) {
+    if (window == nullptr || window->handle() == nullptr) {
+        return;
+    }
+    this->m_window = window;
+    this->m_pressPos = nativeGlobalPos;
+    this->m_windowOrigin = window->handle()->geometry().topLeft();
+    this->m_committedPos = this->m_windowOrigin;
+    this->m_hasPending = false;
+}
+
+void ClientMove::update(const QPoint &nativeGlobalPos) {
+    if (!this->isActive()) {
+        return;
+    }
+    Instrumentation::count(this->m_counters,
+                           Instrumentation::ClientMoveMotions);
+    const auto position =
+        this->m_windowOrigin + (nativeGlobalPos - this->m_pressPos);
+    if (!this->m_hasPending) {
+        this->m_pendingSinceNs = this->m_clock.nsecsElapsed();
+    }
+    this->m_pendingPos = position;
+    this->m_hasPending = true;
+    // The first motion after an idle frame goes out right away, later ones
+    // wait for the next frame tick
+    if (!this->m_frameTimer.isActive()) {
+        this->commit();
+        this->m_frameTimer.start(frameIntervalMs(this->m_window->screen()),
+                                 Qt::PreciseTimer,
+                                 this);
+    }
+}
+
+void ClientMove::finish() {
+    if (!this->isActive()) {
+        return;
+    }
+    this->commit();
+    this->m_frameTimer.stop();
+    this->m_window = nullptr;
+}
+
+bool ClientMove::isActive() const {
+    return !this->m_window.isNull();
+}
+
+void ClientMove::timerEvent(QTimerEvent *event) {
+    if (event->timerId() != this->m_frameTimer.timerId()) {
+        QObject::timerEvent(event);
+        return;
+    }
+    if (!this->m_hasPending || !this->isActive()) {
+        // Nothing moved during the last frame, go idle
+        this->m_frameTimer.stop();
+        return;
+    }
+    this->commit();
+}
+
+void ClientMove::commit() {
+    if (!this->m_hasPending || this->m_window.isNull()) {
+        return;
+    }
+    this->m_hasPending = false;
+    if (this->m_pendingPos == this->m_committedPos) {
+        return;
+    }
+    this->m_committedPos = this->m_pendingPos;
+    XcbConnectionCache::forConnection(QX11Info::connection())
+        .moveWindow(static_cast<xcb_window_t>(this->m_window->winId()),
+                    this->m_committedPos.x(),
+                    this->m_committedPos.y());
+    Instrumentation::count(this->m_counters,
+                           Instrumentation::ClientMoveConfigures);
+    Instrumentation::count(this->m_counters,
+                           Instrumentation::ClientMoveLatencyNs,
+                           this->m_clock.nsecsElapsed() -
+                               this->m_pendingSinceNs);
+}
+
+} // namespace CSD::Internal
@@ -0,0 +1,49 @@
+#pragma once
+
+#include "csdinstrumentation.h"
+
+#include <QBasicTimer>
+#include <QElapsedTimer>
+#include <QObject>
+#include <QPoint>
+#include <QPointer>
+
+class QWindow;
+
+namespace CSD::Internal {
+
+// Moves a window by following the pointer itself, for window managers that
+// ignore _NET_WM_MOVERESIZE. Pointer motion is coalesced so that at most
+// one ConfigureWindow request is sent per display frame.
+class ClientMove final : public QObject {
+    Q_OBJECT
+
+public:
+    explicit ClientMove(Instrumentation::Counters *counters = nullptr,
+                        QObject *parent = nullptr);
+
+    void start(QWindow *window, const QPoint &nativeGlobalPos);
+    void update(const QPoint &nativeGlobalPos);
+    void finish();
+    bool isActive() const;
+
+protected:
+    void timerEvent(QTimerEvent *event) override;
+
+private:
+    void commit();
+
+    QPointer<QWindow> m_window;
+    QPoint m_pressPos;
+    QPoint m_windowOrigin;
+    QPoint m_pendingPos;
+    QPoint m_committedPos;
+    bool m_hasPending = false;
+    // When the oldest motion not yet sent to the X server arrived
+    qint64 m_pendingSinceNs = 0;
+    QBasicTimer m_frameTimer;
+    QElapsedTimer m_clock;
+    Instrumentation::Counters *m_counters;
+};
+
+} // namespace CSD::Internal
@@ -1,10 +1,36 @@
 #include "linuxcsd.h"
 
+#include "csdinstrumentation.h"
+#include "linuxxcb.h"
+
 #include <QEvent>
+#include <QMouseEvent>
+#include <QResizeEvent>
 #include <QWidget>
+#include <QWindow>
+
+#include <QX11Info>
+
+#include <private/qhighdpiscaling_p.h>
+
+#include <array>
 
 namespace CSD::Internal {
 
+// Indexed by HitRegion
+constexpr static std::array<XcbConnectionCache::MoveResizeDirection, 9>
+    moveResizeDirections = {
+        XcbConnectionCache::Move,
+        XcbConnectionCache::SizeLeft,
+        XcbConnectionCache::SizeRight,
+        XcbConnectionCache::SizeTop,
+        XcbConnectionCache::SizeBottom,
+        XcbConnectionCache::SizeTopLeft,
+        XcbConnectionCache::SizeTopRight,
+        XcbConnectionCache::SizeBottomLeft,
+        XcbConnectionCache::SizeBottomRight,
+};
+
 LinuxClientSideDecorationFilter::WidgetCallbacks::WidgetCallbacks(
     Callback onActivationChanged, Callback onWindowStateChanged)
     : onActivationChanged(std::move(onActivationChanged)),
@@ -18,31 +44,187 @@ LinuxClientSideDecorationFilter::~LinuxClientSideDecorationFilter() {
     for (const auto &pair : this->m_callbacks) {
         pair.first->removeEventFilter(this);
     }
+    for (const auto &pair : this->m_windows) {
+        pair.first->removeEventFilter(this);
+    }
 }
 
 bool LinuxClientSideDecorationFilter::eventFilter(QObject *watched,
                                                   QEvent *event) {
-    QWidget *widget = static_cast<QWidget *>(watched);
-    auto resultIterator = this->m_callbacks.find(widget);
+    Instrumentation::count(Instrumentation::FilterDispatches);
+    const auto timer = Instrumentation::ScopedTimer(
+        nullptr, Instrumentation::FilterDispatchNs);
+    const auto type = event->type();
+    switch (type) {
+    case QEvent::Resize:
+    case QEvent::MouseMove:
+    case QEvent::MouseButtonPress:
+    case QEvent::Leave:
+        return this->windowEventFilter(watched, event);
+    case QEvent::ActivationChange:
+    case QEvent::WindowStateChange:
+    case QEvent::Show:
+        break;
+    default:
+        return false;
+    }
+
+    auto resultIterator = this->m_callbacks.find(watched);
+    if (resultIterator == std::end(this->m_callbacks)) {
+        return false;
+    }
 
-    if (event->type() == QEvent::ActivationChange) {
-        resultIterator->second.onActivationChanged();
-    } else if (event->type() == QEvent::WindowStateChange) {
+    auto *widget = static_cast<QWidget *>(watched);
+    if (type == QEvent::ActivationChange) {
+        auto &callbacks = resultIterator->second;
+        const auto span = Instrumentation::TraceSpan(
+            callbacks.activated ? nullptr : "first ActivationChange");
+        callbacks.activated = true;
+        callbacks.onActivationChanged();
+    } else if (type == QEvent::WindowStateChange) {
+        this->updateHitTester(widget, resultIterator->second, widget->size());
         resultIterator->second.onWindowStateChanged();
+    } else {
+        this->watchWindow(widget, resultIterator->second);
     }
 
     return false;
 }
 
+bool LinuxClientSideDecorationFilter::windowEventFilter(QObject *watched,
+                                                        QEvent *event) {
+    auto windowIterator = this->m_windows.find(watched);
+    if (windowIterator == std::end(this->m_windows)) {
+        return false;
+    }
+    auto resultIterator = this->m_callbacks.find(windowIterator->second);
+    if (resultIterator == std::end(this->m_callbacks)) {
+        return false;
+    }
+    auto &callbacks = resultIterator->second;
+    auto *widget = static_cast<QWidget *>(windowIterator->second);
+
+    switch (event->type()) {
+    case QEvent::Resize: {
+        this->updateHitTester(
+            widget, callbacks, static_cast<QResizeEvent *>(event)->size());
+        return false;
+    }
+    case QEvent::MouseMove: {
+        const auto *mouseEvent = static_cast<QMouseEvent *>(event);
+        if (mouseEvent->buttons() != Qt::NoButton) {
+            return false;
+        }
+        const auto region = callbacks.hitTester.classify(mouseEvent->pos());
+        if (region != callbacks.hoveredRegion) {
+            callbacks.hoveredRegion = region;
+            if (region == HitRegion::Client) {
+                widget->unsetCursor();
+            } else {
+                widget->setCursor(HitTester::cursorShape(region));
+            }
+        }
+        return false;
+    }
+    case QEvent::Leave: {
+        if (callbacks.hoveredRegion != HitRegion::Client) {
+            callbacks.hoveredRegion = HitRegion::Client;
+            widget->unsetCursor();
+        }
+        return false;
+    }
+    case QEvent::MouseButtonPress: {
+        const auto *mouseEvent = static_cast<QMouseEvent *>(event);
+        if (mouseEvent->button() != Qt::LeftButton) {
+            return false;
+        }
+        const auto region = callbacks.hitTester.classify(mouseEvent->pos());
+        if (region == HitRegion::Client || callbacks.window == nullptr) {
+            return false;
+        }
+        const auto span =
+            Instrumentation::TraceSpan("edge press to _NET_WM_MOVERESIZE");
+        const QPoint globalPos = QHighDpi::toNativePixels(
+            mouseEvent->globalPos(), callbacks.window->screen());
+        XcbConnectionCache::forConnection(QX11Info::connection())
+            .startMoveResize(
+                static_cast<xcb_window_t>(callbacks.window->winId()),
+                xcbScreenNumber(callbacks.window->screen()),
+                globalPos.x(),
+                globalPos.y(),
+                moveResizeDirections[static_cast<std::size_t>(region)]);
+        return true;
+    }
+    default:
+        return false;
+    }
+}
+
+void LinuxClientSideDecorationFilter::watchWindow(QWidget *widget,
+                                                  WidgetCallbacks &callbacks) {
+    QWindow *window = widget->windowHandle();
+    if (!QX11Info::isPlatformX11() || window == nullptr ||
+        window == callbacks.window) {
+        return;
+    }
+    callbacks.window = window;
+    this->m_windows.emplace(window, widget);
+    connect(window, &QObject::destroyed, this, [this](QObject *object) {
+        auto windowIterator = this->m_windows.find(object);
+        if (windowIterator == std::end(this->m_windows)) {
+            return;
+        }
+        auto resultIterator = this->m_callbacks.find(windowIterator->second);
+        if (resultIterator != std::end(this->m_callbacks) &&
+            resultIterator->second.window == object) {
+            resultIterator->second.window = nullptr;
+        }
+        this->m_windows.erase(windowIterator);
+    });
+    window->installEventFilter(this);
+    this->updateHitTester(widget, callbacks, widget->size());
+}
+
+void LinuxClientSideDecorationFilter::updateHitTester(
+    QWidget *widget, WidgetCallbacks &callbacks, const QSize &size) {
+    const bool fixed = static_cast<bool>(
+        widget->windowState() & (Qt::WindowMaximized | Qt::WindowFullScreen));
+    callbacks.hitTester.setGeometry(
+        size,
+        !fixed && widget->minimumWidth() != widget->maximumWidth(),
+        !fixed && widget->minimumHeight() != widget->maximumHeight());
+}
+
 void LinuxClientSideDecorationFilter::apply(QWidget *widget,
                                             Callback onActivationChanged,
                                             Callback onWindowStateChanged) {
-    this->m_callbacks.emplace(
-        widget,
-        WidgetCallbacks(std::move(onActivationChanged),
-                        std::move(onWindowStateChanged)));
-    widget->installEventFilter(this);
+    const auto span =
+        Instrumentation::TraceSpan("LinuxClientSideDecorationFilter::apply");
+    auto resultIterator = this->m_callbacks.find(widget);
+    if (resultIterator != std::end(this->m_callbacks)) {
+        resultIterator->second.onActivationChanged =
+            std::move(onActivationChanged);
+        resultIterator->second.onWindowStateChanged =
+            std::move(onWindowStateChanged);
+    } else {
+        resultIterator =
+            this->m_callbacks
+                .emplace(widget,
+                         WidgetCallbacks(std::move(onActivationChanged),
+                                         std::move(onWindowStateChanged)))
+                .first;
+        connect(widget,
+                &QObject::destroyed,
+                this,
+                [this](QObject *object) { this->m_callbacks.erase(object); });
+        widget->installEventFilter(this);
+    }
     widget->setWindowFlag(Qt::FramelessWindowHint);
+    this->watchWindow(widget, resultIterator->second);
+}
+
+std::size_t LinuxClientSideDecorationFilter::decoratedWidgetCount() const {
+    return this->m_callbacks.size();
 }
 
 } // namespace CSD::Internal
@@ -1,10 +1,17 @@
 #pragma once
 
+#include "csdhittest.h"
+
 #include <QObject>
 
+#include <cstddef>
 #include <functional>
 #include <unordered_map>
 
+class QSize;
+class QWidget;
+class QWindow;
+
 namespace CSD::Internal {
 
 class LinuxClientSideDecorationFilter : public QObject {
@@ -15,10 +22,25 @@ private:
     struct WidgetCallbacks {
         Callback onActivationChanged;
         Callback onWindowStateChanged;
+        QWindow *window = nullptr;
+        HitTester hitTester;
+        HitRegion hoveredRegion = HitRegion::Client;
+        bool activated = false;
         WidgetCallbacks(Callback onActivationChanged,
                         Callback onWindowStateChanged);
     };
-    std::unordered_map<QWidget *, WidgetCallbacks> m_callbacks;
+    // Keyed by QObject so that entries can still be erased from
+    // QObject::destroyed, after the QWidget part is gone
+    std::unordered_map<QObject *, WidgetCallbacks> m_callbacks;
+    // Window handles of the decorated widgets, which see the mouse events
+    // at the resize borders before any child widget does
+    std::unordered_map<QObject *, QObject *> m_windows;
+
+    void watchWindow(QWidget *widget, WidgetCallbacks &callbacks);
+    void updateHitTester(QWidget *widget,
+                         WidgetCallbacks &callbacks,
+                         const QSize &size);
+    bool windowEventFilter(QObject *watched, QEvent *event);
 
 public:
     explicit LinuxClientSideDecorationFilter(QObject *parent = nullptr);
@@ -27,5 +49,6 @@ public:
     void apply(QWidget *widget,
                Callback onActivationChanged,
                Callback onWindowStateChanged);
+    std::size_t decoratedWidgetCount() const;
 };
 } // namespace CSD::Internal
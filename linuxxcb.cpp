@@ -0,0 +1,278 @@
+#include "linuxxcb.h"
+
+#include "csdinstrumentation.h"
+
+#include <QCoreApplication>
+#include <QGuiApplication>
+#include <QScreen>
+#include <QTimer>
+
+#include <qpa/qplatformnativeinterface.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <iterator>
+#include <memory>
+#include <unordered_map>
+
+namespace CSD::Internal {
+
+constexpr static std::array<const char *, XcbConnectionCache::AtomCount>
+    atomNames = {
+        "_NET_WM_MOVERESIZE",
+        "_NET_SUPPORTED",
+};
+
+int xcbScreenNumber(QScreen *screen) {
+    auto *nativeInterface = QGuiApplication::platformNativeInterface();
+    if (nativeInterface == nullptr || screen == nullptr) {
+        return 0;
+    }
+    return static_cast<int>(reinterpret_cast<quintptr>(
+        nativeInterface->nativeResourceForScreen("x11screen", screen)));
+}
+
+XcbConnectionCache &
+XcbConnectionCache::forConnection(xcb_connection_t *connection) {
+    static std::unordered_map<xcb_connection_t *,
+                              std::unique_ptr<XcbConnectionCache>>
+        caches;
+    auto &cache = caches[connection];
+    if (!cache) {
+        cache.reset(new XcbConnectionCache(connection));
+    }
+    return *cache;
+}
+
+XcbConnectionCache::XcbConnectionCache(xcb_connection_t *connection)
+    : m_connection(connection) {
+    for (std::size_t i = 0; i < AtomCount; ++i) {
+        this->m_atomCookies[i] = xcb_intern_atom(
+            connection,
+            false,
+            static_cast<std::uint16_t>(std::strlen(atomNames[i])),
+            atomNames[i]);
+        this->m_atoms[i] = XCB_ATOM_NONE;
+        this->m_atomResolved[i] = false;
+    }
+    xcb_flush(connection);
+
+    // The roots are part of the connection setup, no request is needed
+    auto rootsIterator = xcb_setup_roots_iterator(xcb_get_setup(connection));
+    for (; rootsIterator.rem > 0; xcb_screen_next(&rootsIterator)) {
+        this->m_rootWindows.push_back(rootsIterator.data->root);
+    }
+    this->m_moveResizeSupported.resize(this->m_rootWindows.size(), 0);
+
+    // The replies are rarely in before the event loop comes back
+    QTimer::singleShot(0, QCoreApplication::instance(), [this]() {
+        if (!this->requestSupported(false)) {
+            return;
+        }
+        QTimer::singleShot(0, QCoreApplication::instance(), [this]() {
+            for (std::size_t i = 0; i < this->m_supportedCookies.size();
+                 ++i) {
+                this->collectSupported(i, false);
+            }
+        });
+    });
+}
+
+xcb_connection_t *XcbConnectionCache::connection() const {
+    return this->m_connection;
+}
+
+xcb_intern_atom_cookie_t XcbConnectionCache::atomCookie(Atom atom) const {
+    return this->m_atomCookies[atom];
+}
+
+xcb_atom_t XcbConnectionCache::atom(Atom atom) {
+    if (!this->m_atomResolved[atom]) {
+        // Usually already queued, but blocks if the reply is still pending
+        Instrumentation::count(Instrumentation::XcbRoundTrips);
+        xcb_intern_atom_reply_t *reply = xcb_intern_atom_reply(
+            this->m_connection, this->m_atomCookies[atom], nullptr);
+        if (reply != nullptr) {
+            this->m_atoms[atom] = reply->atom;
+            free(reply);
+        }
+        this->m_atomResolved[atom] = true;
+    }
+    return this->m_atoms[atom];
+}
+
+bool XcbConnectionCache::pollAtom(Atom atom) {
+    if (this->m_atomResolved[atom]) {
+        return true;
+    }
+    void *reply = nullptr;
+    xcb_generic_error_t *error = nullptr;
+    if (xcb_poll_for_reply(this->m_connection,
+                           this->m_atomCookies[atom].sequence,
+                           &reply,
+                           &error) == 0) {
+        return false;
+    }
+    if (reply != nullptr) {
+        this->m_atoms[atom] =
+            static_cast<xcb_intern_atom_reply_t *>(reply)->atom;
+    }
+    free(reply);
+    free(error);
+    this->m_atomResolved[atom] = true;
+    return true;
+}
+
+bool XcbConnectionCache::requestSupported(bool wait) {
+    if (!this->m_supportedCookies.empty()) {
+        return true;
+    }
+    // Replies arrive in request order, _NET_WM_MOVERESIZE was interned first
+    if (!wait &&
+        (!this->pollAtom(NetSupported) || !this->pollAtom(NetWmMoveResize))) {
+        return false;
+    }
+    const xcb_atom_t netSupported = this->atom(NetSupported);
+    if (netSupported == XCB_ATOM_NONE) {
+        std::fill(std::begin(this->m_moveResizeSupported),
+                  std::end(this->m_moveResizeSupported),
+                  -1);
+        return false;
+    }
+    for (const xcb_window_t root : this->m_rootWindows) {
+        this->m_supportedCookies.push_back(
+            xcb_get_property(this->m_connection,
+                             false,
+                             root,
+                             netSupported,
+                             XCB_ATOM_ATOM,
+                             0,
+                             UINT32_MAX / 4));
+    }
+    xcb_flush(this->m_connection);
+    return true;
+}
+
+bool XcbConnectionCache::collectSupported(std::size_t screen, bool wait) {
+    int &supported = this->m_moveResizeSupported[screen];
+    if (supported != 0) {
+        return true;
+    }
+    xcb_get_property_reply_t *reply = nullptr;
+    if (wait) {
+        reply = xcb_get_property_reply(
+            this->m_connection, this->m_supportedCookies[screen], nullptr);
+    } else {
+        void *polled = nullptr;
+        xcb_generic_error_t *error = nullptr;
+        if (xcb_poll_for_reply(this->m_connection,
+                               this->m_supportedCookies[screen].sequence,
+                               &polled,
+                               &error) == 0) {
+            return false;
+        }
+        free(error);
+        reply = static_cast<xcb_get_property_reply_t *>(polled);
+    }
+    supported = -1;
+    if (reply == nullptr) {
+        return true;
+    }
+    const xcb_atom_t moveResize = this->atom(NetWmMoveResize);
+    const auto *atoms =
+        static_cast<const xcb_atom_t *>(xcb_get_property_value(reply));
+    const int atomCount = xcb_get_property_value_length(reply) /
+                          static_cast<int>(sizeof(xcb_atom_t));
+    for (int i = 0; i < atomCount; ++i) {
+        if (atoms[i] == moveResize) {
+            supported = 1;
+            break;
+        }
+    }
+    free(reply);
+    return true;
+}
+
+xcb_window_t XcbConnectionCache::rootWindow(int screenNumber) const {
+    if (screenNumber < 0 ||
+        static_cast<std::size_t>(screenNumber) >= this->m_rootWindows.size()) {
+        if (this->m_rootWindows.empty()) {
+            return XCB_WINDOW_NONE;
+        }
+        return this->m_rootWindows.front();
+    }
+    return this->m_rootWindows[static_cast<std::size_t>(screenNumber)];
+}
+
+void XcbConnectionCache::startMoveResize(xcb_window_t window,
+                                         int screenNumber,
+                                         int nativeGlobalX,
+                                         int nativeGlobalY,
+                                         MoveResizeDirection direction) {
+    const auto span = Instrumentation::TraceSpan("_NET_WM_MOVERESIZE");
+    xcb_client_message_event_t xev;
+    xev.response_type = XCB_CLIENT_MESSAGE;
+    xev.type = this->atom(NetWmMoveResize);
+    xev.sequence = 0;
+    xev.window = window;
+    xev.format = 32;
+    xev.data.data32[0] = static_cast<std::uint32_t>(nativeGlobalX);
+    xev.data.data32[1] = static_cast<std::uint32_t>(nativeGlobalY);
+    xev.data.data32[2] = direction;
+    xev.data.data32[3] = XCB_BUTTON_INDEX_1;
+    xev.data.data32[4] = 0;
+
+    std::uint32_t eventFlags = XCB_EVENT_MASK_SUBSTRUCTURE_REDIRECT |
+                               XCB_EVENT_MASK_SUBSTRUCTURE_NOTIFY;
+
+    xcb_ungrab_pointer(this->m_connection, XCB_CURRENT_TIME);
+    xcb_send_event(this->m_connection,
+                   false,
+                   this->rootWindow(screenNumber),
+                   eventFlags,
+                   reinterpret_cast<const char *>(&xev));
+}
+
+bool XcbConnectionCache::isMoveResizeSupported(int screenNumber) {
+    if (screenNumber < 0 ||
+        static_cast<std::size_t>(screenNumber) >=
+            this->m_moveResizeSupported.size()) {
+        screenNumber = 0;
+    }
+    if (this->m_moveResizeSupported.empty()) {
+        return false;
+    }
+    int &supported =
+        this->m_moveResizeSupported[static_cast<std::size_t>(screenNumber)];
+    if (supported != 0) {
+        return supported > 0;
+    }
+
+    if (this->requestSupported(true)) {
+        // Usually already queued, otherwise this waits for one round trip
+        // that answers every screen
+        Instrumentation::count(Instrumentation::XcbRoundTrips);
+        for (std::size_t i = 0; i < this->m_supportedCookies.size(); ++i) {
+            this->collectSupported(i, true);
+        }
+    }
+    return supported > 0;
+}
+
+void XcbConnectionCache::moveWindow(xcb_window_t window,
+                                    int nativeX,
+                                    int nativeY) {
+    const std::array<std::uint32_t, 2> values = {
+        static_cast<std::uint32_t>(nativeX),
+        static_cast<std::uint32_t>(nativeY),
+    };
+    xcb_configure_window(this->m_connection,
+                         window,
+                         XCB_CONFIG_WINDOW_X | XCB_CONFIG_WINDOW_Y,
+                         values.data());
+    xcb_flush(this->m_connection);
+}
+
+} // namespace CSD::Internal
@@ -0,0 +1,86 @@
+#pragma once
+
+#include <xcb/xcb.h>
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+class QScreen;
+
+namespace CSD::Internal {
+
+// X11 screen number of a QScreen, as used to index the root windows
+int xcbScreenNumber(QScreen *screen);
+
+// Per-connection cache of the X11 atoms and root windows used by the
+// decorations. All atoms are interned in one pipelined batch when the cache
+// is created. Once the event loop runs, the replies are polled without
+// blocking, _NET_SUPPORTED of every root is requested and its replies are
+// polled in turn, so usually no request has to wait for an X server round
+// trip.
+class XcbConnectionCache {
+public:
+    // _NET_WM_MOVERESIZE directions
+    enum MoveResizeDirection : std::uint32_t {
+        SizeTopLeft = 0,
+        SizeTop = 1,
+        SizeTopRight = 2,
+        SizeRight = 3,
+        SizeBottomRight = 4,
+        SizeBottom = 5,
+        SizeBottomLeft = 6,
+        SizeLeft = 7,
+        Move = 8,
+    };
+
+    enum Atom : std::size_t {
+        NetWmMoveResize,
+        NetSupported,
+        AtomCount,
+    };
+
+    static XcbConnectionCache &forConnection(xcb_connection_t *connection);
+
+    xcb_connection_t *connection() const;
+    xcb_intern_atom_cookie_t atomCookie(Atom atom) const;
+    xcb_atom_t atom(Atom atom);
+    xcb_window_t rootWindow(int screenNumber) const;
+
+    // Hands an interactive move or resize over to the window manager. Only
+    // sends requests, no reply is awaited.
+    void startMoveResize(xcb_window_t window,
+                         int screenNumber,
+                         int nativeGlobalX,
+                         int nativeGlobalY,
+                         MoveResizeDirection direction);
+
+    // Whether the window manager of a screen lists _NET_WM_MOVERESIZE in
+    // _NET_SUPPORTED. Replies that have not been polled yet are collected
+    // for all screens at once, blocking for at most one round trip.
+    bool isMoveResizeSupported(int screenNumber);
+
+    // Moves a top level window without the window manager's help
+    void moveWindow(xcb_window_t window, int nativeX, int nativeY);
+
+private:
+    explicit XcbConnectionCache(xcb_connection_t *connection);
+
+    bool pollAtom(Atom atom);
+    // Both return false if wait is false and the reply is still pending
+    bool requestSupported(bool wait);
+    bool collectSupported(std::size_t screen, bool wait);
+
+    xcb_connection_t *m_connection;
+    std::array<xcb_intern_atom_cookie_t, AtomCount> m_atomCookies;
+    std::array<xcb_atom_t, AtomCount> m_atoms;
+    std::array<bool, AtomCount> m_atomResolved;
+    std::vector<xcb_window_t> m_rootWindows;
+    // Sent for every screen at once, empty until then
+    std::vector<xcb_get_property_cookie_t> m_supportedCookies;
+    // Per screen: 0 unknown, 1 supported, -1 not supported
+    std::vector<int> m_moveResizeSupported;
+};
+
+} // namespace CSD::Internal
@@ -1,148 +1,100 @@
 #include <QApplication>
-#include <QBoxLayout>
-#include <QMainWindow>
-#include <QPushButton>
-#include <QCheckBox>
-#include <QStatusBar>
-#include <QMenuBar>
-#include <QMenu>
-#include <QMessageBox>
+#include <QCommandLineParser>
 
-#include "csdtitlebar.h"
-#ifdef _WIN32
-#include "win32csd.h"
-#else
-#include "linuxcsd.h"
+#include "demowindow.h"
+#ifdef CSD_QUICK
+#include "csdquicktitlebar.h"
+
+#include <QQmlApplicationEngine>
 #endif
 
-class DemoWindow : public QMainWindow {
+#ifdef CSD_QUICK
+// Run with QT_QUICK_BACKEND=software to check the title bar without a GPU
+static const char quickDemo[] = R"(
+import QtQuick 2.9
+import QtQuick.Window 2.2
+import CSD 1.0
 
-public:
-    DemoWindow(QWidget *parent = nullptr) : QMainWindow(parent) {
-        this->setCentralWidget(new QWidget(this));
-        QMenu *fileMenu = menuBar()->addMenu("&File");
-        fileMenu->addSeparator();
-        auto *closeAct = fileMenu->addAction("&Quit", this, &QWidget::close);
-        closeAct->setStatusTip("Exit the application");
-        QMenu *aboutMenu = menuBar()->addMenu("About");
-        QAction *aboutAct = aboutMenu->addAction("&About", this, [this] {
-            QMessageBox::about(this, "About qt-csd Demo", "Qt Client Side Decorations Demo");
-        });
-        aboutAct->setStatusTip(tr("Show the application's About box"));
-        QAction *aboutQtAct = aboutMenu->addAction(tr("About &Qt"), qApp, &QApplication::aboutQt);
-        aboutQtAct->setStatusTip(tr("Show the Qt library's About box"));
-        auto *layout = new QVBoxLayout;
-        layout->setMargin(0);
-        this->centralWidget()->setLayout(layout);
-        auto *buttonToggleFullScr = new QPushButton("Toggle full screen", this);
-        connect(buttonToggleFullScr, &QPushButton::clicked, this, [this] {
-            this->setWindowState(this->windowState() ^ Qt::WindowFullScreen);
-        });
-        auto *checkBoxMinimize = new QCheckBox("Minimizable", this);
-        checkBoxMinimize->setChecked(true);
-        auto *checkBoxMaximize = new QCheckBox("Maximizable", this);
-        checkBoxMaximize->setChecked(true);
-        auto *checkBoxResize = new QCheckBox("Resizable", this);
-        checkBoxResize->setChecked(true);
-        auto *subWidget = new QWidget(this);
-        auto *outerLayout = new QVBoxLayout();
-        outerLayout->addStretch();
-        auto *centralLayout1 = new QHBoxLayout();
-        centralLayout1->addStretch();
-        centralLayout1->addWidget(checkBoxMaximize);
-        centralLayout1->addStretch();
-        outerLayout->addLayout(centralLayout1);
-        auto *centralLayout2 = new QHBoxLayout();
-        centralLayout2->addStretch();
-        centralLayout2->addWidget(checkBoxMinimize);
-        centralLayout2->addStretch();
-        outerLayout->addLayout(centralLayout2);
-        auto *centralLayout3 = new QHBoxLayout();
-        centralLayout3->addStretch();
-        centralLayout3->addWidget(checkBoxResize);
-        centralLayout3->addStretch();
-        outerLayout->addLayout(centralLayout3);
-        auto *centralLayout4 = new QHBoxLayout();
-        centralLayout4->addStretch();
-        centralLayout4->addWidget(buttonToggleFullScr);
-        centralLayout4->addStretch();
-        outerLayout->addLayout(centralLayout4);
-        outerLayout->addStretch();
-        subWidget->setLayout(outerLayout);
-        this->m_titleBar = new CSD::TitleBar(
-#ifdef _WIN32
-            CSD::CaptionButtonStyle::win,
-#else
-            CSD::CaptionButtonStyle::custom,
-#endif
-            QIcon(),
-            this);
-        connect(checkBoxMinimize, &QCheckBox::toggled, this, [this](bool checked) {
-            this->m_titleBar->setMinimizable(checked);
-        });
-        connect(checkBoxMaximize, &QCheckBox::toggled, this, [this](bool checked) {
-            this->m_titleBar->setMaximizable(checked);
-        });
-        layout->addWidget(this->m_titleBar);
-        layout->addWidget(subWidget);
-        this->statusBar()->showMessage("Resize me by the grip ...");
-        connect(checkBoxResize, &QCheckBox::toggled, this, [this](bool checked){
-            this->statusBar()->setVisible(checked);
-        });
-        connect(
-            this->m_titleBar, &CSD::TitleBar::minimizeClicked, this, [this]() {
-                this->setWindowState(this->windowState() |
-                                     Qt::WindowMinimized);
-            });
-        connect(this->m_titleBar,
-                &CSD::TitleBar::maximizeRestoreClicked,
-                this,
-                [this]() {
-                    this->setWindowState(this->windowState() ^
-                                         Qt::WindowMaximized);
-                });
-        connect(this->m_titleBar,
-                &CSD::TitleBar::closeClicked,
-                this,
-                &QWidget::close);
-    }
+Window {
+    id: window
+    width: 640
+    height: 480
+    visible: true
+    flags: Qt.Window | Qt.FramelessWindowHint
 
-    CSD::TitleBar *titleBar() {
-        return this->m_titleBar;
+    TitleBar {
+        id: titleBar
+        width: parent.width
+        active: window.active
+        maximized: window.visibility === Window.Maximized
+        onMinimizeClicked: window.showMinimized()
+        onMaximizeRestoreClicked: maximized ? window.showNormal()
+                                            : window.showMaximized()
+        onCloseClicked: window.close()
     }
+}
+)";
 
-private:
-    CSD::TitleBar *m_titleBar;
-};
+static int runQuickDemo(QApplication &app) {
+    CSD::QuickTitleBar::registerType();
+    auto engine = QQmlApplicationEngine();
+    engine.loadData(quickDemo);
+    if (engine.rootObjects().isEmpty()) {
+        return 1;
+    }
+    return app.exec();
+}
+#endif
 
 int main(int argc, char *argv[]) {
     QApplication::setAttribute(Qt::AA_EnableHighDpiScaling);
     QApplication::setAttribute(Qt::AA_UseHighDpiPixmaps);
-    auto *app = new QApplication(argc, argv);
+    QApplication app(argc, argv);
     QApplication::setApplicationName("qt-csd");
-    auto *mainWindow = new DemoWindow();
-    mainWindow->resize(640, 480);
 
-#ifdef _WIN32
-    auto *filter = new CSD::Internal::Win32ClientSideDecorationFilter(app);
-    app->installNativeEventFilter(filter);
-#else
-    auto *filter = new CSD::Internal::LinuxClientSideDecorationFilter(app);
+    auto parser = QCommandLineParser();
+    parser.addHelpOption();
+    const auto paintedOption = QCommandLineOption(
+        "painted",
+        "Draw the caption icon and buttons in the title bar instead of "
+        "creating widgets for them.");
+    const auto themedOption = QCommandLineOption(
+        "themed",
+        "Paint the title bar from a TitleBarTheme instead of the widget "
+        "style.");
+    const auto styleSheetOption = QCommandLineOption(
+        "style-sheet", "Set <sheet> as the application style sheet.", "sheet");
+    parser.addOption(paintedOption);
+    parser.addOption(themedOption);
+    parser.addOption(styleSheetOption);
+#ifdef CSD_QUICK
+    const auto quickOption = QCommandLineOption(
+        "quick", "Show a QML window with the Qt Quick title bar.");
+    parser.addOption(quickOption);
 #endif
-    filter->apply(
-        mainWindow,
+    parser.process(app);
+    const auto titleBarMode = parser.isSet(paintedOption)
+                                  ? CSD::TitleBarMode::Painted
+                                  : CSD::TitleBarMode::Widgets;
+    const bool themed = parser.isSet(themedOption);
+    if (parser.isSet(styleSheetOption)) {
+        app.setStyleSheet(parser.value(styleSheetOption));
+    }
+
+#ifdef CSD_QUICK
+    if (parser.isSet(quickOption)) {
+        return runQuickDemo(app);
+    }
+#endif
+
+    auto filter = DecorationFilter();
 #ifdef _WIN32
-        [mainWindow]() { return mainWindow->titleBar()->hovered(); },
+    app.installNativeEventFilter(&filter);
 #endif
-        [mainWindow] {
-            const bool on = mainWindow->isActiveWindow();
-            mainWindow->titleBar()->setActive(on);
-        },
-        [mainWindow] {
-            mainWindow->titleBar()->onWindowStateChange(
-                mainWindow->windowState());
-        });
 
-    mainWindow->show();
-    return app->exec();
+    auto mainWindow = DemoWindow(titleBarMode, themed);
+    mainWindow.resize(640, 480);
+    decorate(&filter, &mainWindow);
+    mainWindow.show();
+    return app.exec();
 }
@@ -1,5 +1,7 @@
 #include "qtwinbackports.h"
 
+#include "csdpixelkernels.h"
+
 namespace CSD::QtWinBackports {
 
 template <typename Int> static inline Int pad4(Int v) {
@@ -64,15 +66,13 @@ qt_imageFromWinIconHBITMAP(HDC hdc, HBITMAP bitmap, int w, int h) {
 }
 
 static inline bool hasAlpha(const QImage &image) {
-    const int w = image.width();
+    const auto w = static_cast<std::size_t>(image.width());
     const int h = image.height();
     for (int y = 0; y < h; ++y) {
-        const QRgb *scanLine =
-            reinterpret_cast<const QRgb *>(image.scanLine(y));
-        for (int x = 0; x < w; ++x) {
-            if (qAlpha(scanLine[x]) != 0)
-                return true;
-        }
+        if (Internal::anyAlpha(
+                reinterpret_cast<const quint32 *>(image.constScanLine(y)),
+                w))
+            return true;
     }
     return false;
 }
@@ -109,18 +109,14 @@ QPixmap qt_pixmapFromWinHICON(HICON icon) {
         DrawIconEx(hdc, 0, 0, icon, w, h, 0, nullptr, DI_MASK);
         const QImage mask = qt_imageFromWinIconHBITMAP(hdc, winBitmap, w, h);
         for (int y = 0; y < h; y++) {
-            QRgb *scanlineImage = reinterpret_cast<QRgb *>(image.scanLine(y));
-            const QRgb *scanlineMask =
-                mask.isNull()
-                    ? nullptr
-                    : reinterpret_cast<const QRgb *>(mask.scanLine(y));
-            for (int x = 0; x < w; x++) {
-                if (scanlineMask && qRed(scanlineMask[x]) != 0)
-                    scanlineImage[x] = 0; // mask out this pixel
-                else
-                    scanlineImage[x] |=
-                        0xff000000; // set the alpha channel to 255
-            }
+            const quint32 *scanlineMask =
+                mask.isNull() ? nullptr
+                              : reinterpret_cast<const quint32 *>(
+                                    mask.constScanLine(y));
+            Internal::applyIconMask(
+                reinterpret_cast<quint32 *>(image.scanLine(y)),
+                scanlineMask,
+                static_cast<std::size_t>(w));
         }
     }
     // dispose resources created by iconinfo call
@@ -0,0 +1,313 @@
+#include "csdtitlebar.h"
+#include "csdtitlebarbutton.h"
+
+#include <QApplication>
+#include <QBoxLayout>
+#include <QFile>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QPixmap>
+#include <QRegularExpression>
+#include <QTemporaryFile>
+#include <QTest>
+
+#include <cstdio>
+#include <utility>
+
+Q_DECLARE_METATYPE(CSD::CaptionButtonStyle)
+Q_DECLARE_METATYPE(CSD::TitleBarMode)
+Q_DECLARE_METATYPE(CSD::TitleBarButton::Role)
+
+namespace {
+
+constexpr CSD::CaptionButtonStyle styles[] = {
+    CSD::CaptionButtonStyle::custom,
+    CSD::CaptionButtonStyle::win,
+    CSD::CaptionButtonStyle::mac,
+};
+
+const char *styleName(CSD::CaptionButtonStyle style) {
+    switch (style) {
+    case CSD::CaptionButtonStyle::custom:
+        return "custom";
+    case CSD::CaptionButtonStyle::win:
+        return "win";
+    case CSD::CaptionButtonStyle::mac:
+        return "mac";
+    }
+    return "";
+}
+
+const char *modeName(CSD::TitleBarMode mode) {
+    return mode == CSD::TitleBarMode::Painted ? "painted" : "widgets";
+}
+
+QIcon captionIcon() {
+    auto pixmap = QPixmap(32, 32);
+    pixmap.fill(QColor(0x30, 0x80, 0xd0));
+    return QIcon(pixmap);
+}
+
+// A shown window holding a single title bar, so that repaint() paints
+// synchronously
+struct Host {
+    Host(CSD::CaptionButtonStyle style, CSD::TitleBarMode mode) {
+        auto *layout = new QVBoxLayout(&this->window);
+        layout->setMargin(0);
+        this->titleBar =
+            new CSD::TitleBar(style, captionIcon(), &this->window, mode);
+        layout->addWidget(this->titleBar);
+        layout->addStretch();
+        this->window.resize(640, 120);
+        this->window.show();
+    }
+
+    QWidget window;
+    CSD::TitleBar *titleBar = nullptr;
+};
+
+void addStyleModeRows() {
+    QTest::addColumn<CSD::CaptionButtonStyle>("style");
+    QTest::addColumn<CSD::TitleBarMode>("mode");
+    for (const auto style : styles) {
+        for (const auto mode :
+             {CSD::TitleBarMode::Widgets, CSD::TitleBarMode::Painted}) {
+            QTest::addRow("%s-%s", styleName(style), modeName(mode))
+                << style << mode;
+        }
+    }
+}
+
+// Delivers the queued commit of the title bar's pending state
+void commit(CSD::TitleBar *titleBar) {
+    QCoreApplication::sendPostedEvents(titleBar, QEvent::MetaCall);
+}
+
+} // namespace
+
+class TitleBarBenchmark : public QObject {
+    Q_OBJECT
+
+private slots:
+    void construct_data() {
+        addStyleModeRows();
+    }
+
+    void construct() {
+        QFETCH(CSD::CaptionButtonStyle, style);
+        QFETCH(CSD::TitleBarMode, mode);
+        auto host = QWidget();
+        const auto icon = captionIcon();
+        QBENCHMARK {
+            auto titleBar = CSD::TitleBar(style, icon, &host, mode);
+        }
+    }
+
+    void titleBarPaint_data() {
+        addStyleModeRows();
+    }
+
+    void titleBarPaint() {
+        QFETCH(CSD::CaptionButtonStyle, style);
+        QFETCH(CSD::TitleBarMode, mode);
+        auto host = Host(style, mode);
+        QVERIFY(QTest::qWaitForWindowExposed(&host.window));
+        QBENCHMARK {
+            host.titleBar->repaint();
+        }
+    }
+
+    void buttonPaint_data() {
+        QTest::addColumn<CSD::CaptionButtonStyle>("style");
+        QTest::addColumn<CSD::TitleBarButton::Role>("role");
+        const std::pair<CSD::TitleBarButton::Role, const char *> roles[] = {
+            {CSD::TitleBarButton::CaptionIcon, "captionicon"},
+            {CSD::TitleBarButton::Minimize, "minimize"},
+            {CSD::TitleBarButton::MaximizeRestore, "maximizerestore"},
+            {CSD::TitleBarButton::Close, "close"},
+        };
+        for (const auto style : styles) {
+            for (const auto &role : roles) {
+                QTest::addRow("%s-%s", styleName(style), role.second)
+                    << style << role.first;
+            }
+        }
+    }
+
+    void buttonPaint() {
+        QFETCH(CSD::CaptionButtonStyle, style);
+        QFETCH(CSD::TitleBarButton::Role, role);
+        auto host = Host(style, CSD::TitleBarMode::Widgets);
+        QVERIFY(QTest::qWaitForWindowExposed(&host.window));
+        CSD::TitleBarButton *button = nullptr;
+        for (auto *child :
+             host.titleBar->findChildren<CSD::TitleBarButton *>()) {
+            if (child->role() == role) {
+                button = child;
+            }
+        }
+        QVERIFY(button != nullptr);
+        QBENCHMARK {
+            button->repaint();
+        }
+    }
+
+    void setActive_data() {
+        addStyleModeRows();
+    }
+
+    void setActive() {
+        QFETCH(CSD::CaptionButtonStyle, style);
+        QFETCH(CSD::TitleBarMode, mode);
+        auto host = Host(style, mode);
+        QBENCHMARK {
+            host.titleBar->setActive(!host.titleBar->isActive());
+            commit(host.titleBar);
+        }
+    }
+
+    void setMaximized_data() {
+        addStyleModeRows();
+    }
+
+    void setMaximized() {
+        QFETCH(CSD::CaptionButtonStyle, style);
+        QFETCH(CSD::TitleBarMode, mode);
+        auto host = Host(style, mode);
+        QBENCHMARK {
+            host.titleBar->setMaximized(!host.titleBar->isMaximized());
+            commit(host.titleBar);
+        }
+    }
+
+    void onWindowStateChange_data() {
+        addStyleModeRows();
+    }
+
+    void onWindowStateChange() {
+        QFETCH(CSD::CaptionButtonStyle, style);
+        QFETCH(CSD::TitleBarMode, mode);
+        auto host = Host(style, mode);
+        QBENCHMARK {
+            host.titleBar->onWindowStateChange(
+                host.titleBar->isMaximized() ? Qt::WindowNoState
+                                             : Qt::WindowMaximized);
+            commit(host.titleBar);
+        }
+    }
+
+    void hovered_data() {
+        addStyleModeRows();
+    }
+
+    void hovered() {
+        QFETCH(CSD::CaptionButtonStyle, style);
+        QFETCH(CSD::TitleBarMode, mode);
+        auto host = Host(style, mode);
+        auto count = 0;
+        QBENCHMARK {
+            count += host.titleBar->hovered() ? 1 : 0;
+        }
+        QVERIFY(count >= 0);
+    }
+
+    void captionIconPathsForState() {
+        std::size_t length = 0;
+        QBENCHMARK {
+            for (const auto style : styles) {
+                for (auto state = 0; state < 16; ++state) {
+                    const auto paths =
+                        CSD::Internal::captionIconPathsForState(
+                            (state & 8) != 0,
+                            (state & 4) != 0,
+                            (state & 2) != 0,
+                            (state & 1) != 0,
+                            style);
+                    length += static_cast<std::size_t>(paths[0].size());
+                }
+            }
+        }
+        QVERIFY(length > 0);
+    }
+};
+
+namespace {
+
+// QtTest has no JSON logger. "-o <file>,json" runs the benchmarks with the
+// CSV logger and converts its rows.
+int writeJson(const QString &csvPath, const QString &target) {
+    auto csv = QFile(csvPath);
+    if (!csv.open(QIODevice::ReadOnly | QIODevice::Text)) {
+        return 1;
+    }
+    static const auto row = QRegularExpression(
+        R"(^"([^"]*)","([^"]*)","([^"]*)",([^,]+),([^,]+),(\d+)$)");
+    auto results = QJsonArray();
+    while (!csv.atEnd()) {
+        const auto line = QString::fromUtf8(csv.readLine()).trimmed();
+        const auto match = row.match(line);
+        if (!match.hasMatch()) {
+            continue;
+        }
+        results.append(QJsonObject{
+            {"function", match.captured(1)},
+            {"tag", match.captured(2)},
+            {"metric", match.captured(3)},
+            {"value", match.captured(4).toDouble()},
+            {"total", match.captured(5).toDouble()},
+            {"iterations", match.captured(6).toInt()},
+        });
+    }
+    const auto json =
+        QJsonDocument(QJsonObject{{"results", results}}).toJson();
+    if (target == "-") {
+        std::fwrite(json.constData(),
+                    1,
+                    static_cast<std::size_t>(json.size()),
+                    stdout);
+        return 0;
+    }
+    auto out = QFile(target);
+    if (!out.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        return 1;
+    }
+    out.write(json);
+    return 0;
+}
+
+} // namespace
+
+int main(int argc, char *argv[]) {
+    if (!qEnvironmentVariableIsSet("QT_QPA_PLATFORM")) {
+        qputenv("QT_QPA_PLATFORM", "offscreen");
+    }
+    QApplication app(argc, argv);
+    app.setAttribute(Qt::AA_Use96Dpi, true);
+
+    auto arguments = QApplication::arguments();
+    auto jsonTarget = QString();
+    auto csv = QTemporaryFile();
+    for (auto i = 1; i + 1 < arguments.size(); ++i) {
+        if (arguments[i] != "-o" || !arguments[i + 1].endsWith(",json")) {
+            continue;
+        }
+        if (!csv.open()) {
+            std::fputs("Cannot create the CSV file\n", stderr);
+            return 1;
+        }
+        csv.close();
+        jsonTarget = arguments[i + 1].chopped(5);
+        arguments[i + 1] = csv.fileName() + ",csv";
+    }
+
+    auto benchmark = TitleBarBenchmark();
+    const auto failures = QTest::qExec(&benchmark, arguments);
+    if (!jsonTarget.isEmpty() && writeJson(csv.fileName(), jsonTarget) != 0) {
+        std::fputs("Cannot write the JSON results\n", stderr);
+        return 1;
+    }
+    return failures;
+}
+
+#include "csdbench.moc"
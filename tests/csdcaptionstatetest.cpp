@@ -0,0 +1,146 @@
+#include "csdglyphraster.h"
+#include "csdtitlebar.h"
+
+#include <QFile>
+#include <QTest>
+
+Q_DECLARE_METATYPE(CSD::CaptionButtonStyle)
+
+namespace {
+
+using CSD::Internal::captionIconPathsForState;
+
+constexpr CSD::CaptionButtonStyle styles[] = {
+    CSD::CaptionButtonStyle::custom,
+    CSD::CaptionButtonStyle::win,
+    CSD::CaptionButtonStyle::mac,
+};
+
+const char *styleName(CSD::CaptionButtonStyle style) {
+    switch (style) {
+    case CSD::CaptionButtonStyle::custom:
+        return "custom";
+    case CSD::CaptionButtonStyle::win:
+        return "win";
+    case CSD::CaptionButtonStyle::mac:
+        return "mac";
+    }
+    return "";
+}
+
+} // namespace
+
+// Checks the table generated by generate_caption_state_table.cmake against
+// the resources compiled into the binary and the rules every style follows
+class CaptionStateTableTest : public QObject {
+    Q_OBJECT
+
+private slots:
+    void paths_data() {
+        QTest::addColumn<CSD::CaptionButtonStyle>("style");
+        QTest::addColumn<bool>("active");
+        QTest::addColumn<bool>("maximized");
+        QTest::addColumn<bool>("hovered");
+        QTest::addColumn<bool>("pressed");
+        for (const auto style : styles) {
+            for (auto state = 0; state < 16; ++state) {
+                const bool active = (state & 8) != 0;
+                const bool maximized = (state & 4) != 0;
+                const bool hovered = (state & 2) != 0;
+                const bool pressed = (state & 1) != 0;
+                QTest::addRow("%s-a%dm%dh%dp%d",
+                              styleName(style),
+                              active,
+                              maximized,
+                              hovered,
+                              pressed)
+                    << style << active << maximized << hovered << pressed;
+            }
+        }
+    }
+
+    void paths() {
+        QFETCH(CSD::CaptionButtonStyle, style);
+        QFETCH(bool, active);
+        QFETCH(bool, maximized);
+        QFETCH(bool, hovered);
+        QFETCH(bool, pressed);
+        const auto paths = captionIconPathsForState(
+            active, maximized, hovered, pressed, style);
+        for (const auto path : paths) {
+            const auto file = path.toString();
+            QVERIFY2(QFile::exists(file), qPrintable(file));
+            QVERIFY2(!CSD::Internal::rasterizeGlyphImage(file, 1.0, {16, 16})
+                          .isNull(),
+                     qPrintable(file));
+        }
+
+        const auto restored =
+            captionIconPathsForState(active, true, hovered, pressed, style);
+        const auto normal =
+            captionIconPathsForState(active, false, hovered, pressed, style);
+        QCOMPARE(restored[0], normal[0]);
+        QCOMPARE(restored[2], normal[2]);
+        // Mac buttons only show their symbols while hovered or pressed
+        const bool macIdle =
+            style == CSD::CaptionButtonStyle::mac && !hovered && !pressed;
+        if (!macIdle) {
+            QVERIFY(restored[1] != normal[1]);
+        }
+        if (macIdle && !active) {
+            // One grey dot for all buttons of an inactive window
+            QCOMPARE(paths[1], paths[0]);
+            QCOMPARE(paths[2], paths[0]);
+        } else {
+            QVERIFY(paths[1] != paths[0]);
+            QVERIFY(paths[2] != paths[0]);
+        }
+
+        if (style != CSD::CaptionButtonStyle::mac) {
+            // Alpha masks, tinted at runtime
+            QCOMPARE(paths,
+                     captionIconPathsForState(
+                         false, maximized, false, false, style));
+        }
+    }
+
+    void macStates() {
+        const auto mac = CSD::CaptionButtonStyle::mac;
+        const auto normal =
+            captionIconPathsForState(true, false, false, false, mac);
+        const auto hovered =
+            captionIconPathsForState(true, false, true, false, mac);
+        const auto pressed =
+            captionIconPathsForState(true, false, true, true, mac);
+        for (std::size_t button = 0; button < 3; ++button) {
+            QVERIFY(normal[button] != hovered[button]);
+            QVERIFY(hovered[button] != pressed[button]);
+            QVERIFY(normal[button] != pressed[button]);
+        }
+        // Hover and press look the same in inactive windows
+        QCOMPARE(captionIconPathsForState(false, false, true, false, mac),
+                 hovered);
+        QCOMPARE(captionIconPathsForState(false, false, true, true, mac),
+                 pressed);
+    }
+
+    void stylesDoNotShareIcons() {
+        for (const auto maximized : {false, true}) {
+            const auto custom =
+                captionIconPathsForState(true,
+                                         maximized,
+                                         false,
+                                         false,
+                                         CSD::CaptionButtonStyle::custom);
+            const auto win = captionIconPathsForState(
+                true, maximized, false, false, CSD::CaptionButtonStyle::win);
+            for (std::size_t button = 0; button < 3; ++button) {
+                QVERIFY(custom[button] != win[button]);
+            }
+        }
+    }
+};
+
+QTEST_GUILESS_MAIN(CaptionStateTableTest)
+
+#include "csdcaptionstatetest.moc"
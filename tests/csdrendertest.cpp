@@ -0,0 +1,242 @@
+#include "csdcaptionbuttons.h"
+#include "csdstylemetrics.h"
+#include "csdtitlebar.h"
+#include "csdtitlebarbutton.h"
+
+#include <QApplication>
+#include <QBoxLayout>
+#include <QDir>
+#include <QElapsedTimer>
+#include <QImage>
+#include <QMouseEvent>
+#include <QPixmap>
+#include <QTest>
+
+#include <cstdlib>
+
+Q_DECLARE_METATYPE(CSD::CaptionButtonStyle)
+Q_DECLARE_METATYPE(CSD::TitleBarMode)
+
+namespace {
+
+// Allowed difference per color channel, and the share of pixels that may
+// exceed it, for antialiasing that differs between raster backends
+constexpr int channelTolerance = 2;
+constexpr double mismatchTolerance = 0.001;
+
+constexpr CSD::CaptionButtonStyle styles[] = {
+    CSD::CaptionButtonStyle::custom,
+    CSD::CaptionButtonStyle::win,
+    CSD::CaptionButtonStyle::mac,
+};
+
+const char *styleName(CSD::CaptionButtonStyle style) {
+    switch (style) {
+    case CSD::CaptionButtonStyle::custom:
+        return "custom";
+    case CSD::CaptionButtonStyle::win:
+        return "win";
+    case CSD::CaptionButtonStyle::mac:
+        return "mac";
+    }
+    return "";
+}
+
+QIcon captionIcon() {
+    auto pixmap = QPixmap(32, 32);
+    pixmap.fill(QColor(0x30, 0x80, 0xd0));
+    return QIcon(pixmap);
+}
+
+QPoint closeButtonCenter(const CSD::TitleBar *titleBar) {
+    const auto layout = CSD::Internal::layoutCaption(
+        titleBar->size(),
+        CSD::Internal::styleMetrics(titleBar->style(),
+                                    titleBar->devicePixelRatioF()),
+        CSD::Internal::captionLeftMargin,
+        true,
+        true,
+        titleBar->layoutDirection());
+    return layout.parts[CSD::TitleBarButton::Close].center();
+}
+
+void sendMouseEvent(QWidget *widget,
+                    QEvent::Type type,
+                    const QPoint &pos,
+                    Qt::MouseButton button) {
+    auto event = QMouseEvent(type,
+                             pos,
+                             widget->mapToGlobal(pos),
+                             button,
+                             type == QEvent::MouseMove ? Qt::NoButton
+                                                       : button,
+                             Qt::NoModifier);
+    QApplication::sendEvent(widget, &event);
+}
+
+// Puts the close button, or every button in mac style, into the hover and
+// press state without a real cursor
+void setCloseButtonState(CSD::TitleBar *titleBar,
+                         CSD::TitleBarMode mode,
+                         bool hovered,
+                         bool pressed) {
+    if (mode == CSD::TitleBarMode::Painted) {
+        const auto pos = closeButtonCenter(titleBar);
+        if (hovered) {
+            sendMouseEvent(titleBar, QEvent::MouseMove, pos, Qt::NoButton);
+        }
+        if (pressed) {
+            sendMouseEvent(
+                titleBar, QEvent::MouseButtonPress, pos, Qt::LeftButton);
+        }
+        return;
+    }
+    for (auto *button : titleBar->findChildren<CSD::TitleBarButton *>()) {
+        if (button->role() != CSD::TitleBarButton::Close) {
+            continue;
+        }
+        button->setAttribute(Qt::WA_UnderMouse, hovered);
+        button->setFader(hovered ? 1.0 : 0.0);
+        button->setDown(pressed);
+    }
+}
+
+int mismatchedPixels(const QImage &actual, const QImage &expected) {
+    auto mismatched = 0;
+    for (auto y = 0; y < actual.height(); ++y) {
+        const auto *actualLine =
+            reinterpret_cast<const QRgb *>(actual.constScanLine(y));
+        const auto *expectedLine =
+            reinterpret_cast<const QRgb *>(expected.constScanLine(y));
+        for (auto x = 0; x < actual.width(); ++x) {
+            const auto a = actualLine[x];
+            const auto e = expectedLine[x];
+            if (std::abs(qRed(a) - qRed(e)) > channelTolerance ||
+                std::abs(qGreen(a) - qGreen(e)) > channelTolerance ||
+                std::abs(qBlue(a) - qBlue(e)) > channelTolerance ||
+                std::abs(qAlpha(a) - qAlpha(e)) > channelTolerance) {
+                ++mismatched;
+            }
+        }
+    }
+    return mismatched;
+}
+
+} // namespace
+
+// Renders TitleBar for every caption button style, mode and state and
+// compares it with the images in tests/golden. The device pixel ratio is
+// QT_SCALE_FACTOR, set per run by ctest. CSD_UPDATE_GOLDEN=1 rewrites the
+// images instead.
+class TitleBarRenderTest : public QObject {
+    Q_OBJECT
+
+private slots:
+    void render_data() {
+        QTest::addColumn<CSD::CaptionButtonStyle>("style");
+        QTest::addColumn<CSD::TitleBarMode>("mode");
+        QTest::addColumn<bool>("active");
+        QTest::addColumn<bool>("maximized");
+        QTest::addColumn<bool>("hovered");
+        QTest::addColumn<bool>("pressed");
+        for (const auto mode :
+             {CSD::TitleBarMode::Widgets, CSD::TitleBarMode::Painted}) {
+            for (const auto style : styles) {
+                for (auto state = 0; state < 16; ++state) {
+                    const bool active = (state & 8) != 0;
+                    const bool maximized = (state & 4) != 0;
+                    const bool hovered = (state & 2) != 0;
+                    const bool pressed = (state & 1) != 0;
+                    QTest::addRow(
+                        "%s-%s-a%dm%dh%dp%d",
+                        mode == CSD::TitleBarMode::Painted ? "painted"
+                                                           : "widgets",
+                        styleName(style),
+                        active,
+                        maximized,
+                        hovered,
+                        pressed)
+                        << style << mode << active << maximized << hovered
+                        << pressed;
+                }
+            }
+        }
+    }
+
+    void render() {
+        QFETCH(CSD::CaptionButtonStyle, style);
+        QFETCH(CSD::TitleBarMode, mode);
+        QFETCH(bool, active);
+        QFETCH(bool, maximized);
+        QFETCH(bool, hovered);
+        QFETCH(bool, pressed);
+
+        auto window = QWidget();
+        auto *layout = new QVBoxLayout(&window);
+        layout->setMargin(0);
+        auto *titleBar =
+            new CSD::TitleBar(style, captionIcon(), &window, mode);
+        titleBar->setActiveColor(QColor(0x20, 0x50, 0x90));
+        titleBar->setInactiveColor(QColor(0xe0, 0xe0, 0xe0));
+        titleBar->setHoverColor(QColor(0x80, 0x80, 0x80, 0x80));
+        layout->addWidget(titleBar);
+        layout->addStretch();
+        window.resize(480, 80);
+        window.show();
+        QVERIFY(QTest::qWaitForWindowExposed(&window));
+
+        titleBar->setActive(active);
+        titleBar->setMaximized(maximized);
+        QCoreApplication::sendPostedEvents(titleBar, QEvent::MetaCall);
+        setCloseButtonState(titleBar, mode, hovered, pressed);
+
+        const qreal dpr = titleBar->devicePixelRatioF();
+        auto timer = QElapsedTimer();
+        timer.start();
+        auto image = QImage(titleBar->size() * dpr,
+                            QImage::Format_ARGB32_Premultiplied);
+        image.setDevicePixelRatio(dpr);
+        image.fill(Qt::transparent);
+        titleBar->render(&image);
+        QTest::setBenchmarkResult(static_cast<qreal>(timer.nsecsElapsed()),
+                                  QTest::WalltimeNanoseconds);
+
+        const auto tag = QString::fromLatin1(QTest::currentDataTag());
+        const auto name =
+            QStringLiteral("%1@%2.png").arg(tag).arg(qRound(dpr * 100));
+        const auto goldenDir = QDir(QStringLiteral(CSD_GOLDEN_DIR));
+        if (qEnvironmentVariableIntValue("CSD_UPDATE_GOLDEN") != 0) {
+            QVERIFY(goldenDir.mkpath("."));
+            QVERIFY(image.save(goldenDir.filePath(name)));
+            return;
+        }
+        auto golden = QImage(goldenDir.filePath(name));
+        if (golden.isNull()) {
+            QSKIP("No golden image, record it with CSD_UPDATE_GOLDEN=1");
+        }
+        golden = golden.convertToFormat(QImage::Format_ARGB32_Premultiplied);
+        QCOMPARE(image.size(), golden.size());
+        const int mismatched = mismatchedPixels(image, golden);
+        if (mismatched >
+            qRound(mismatchTolerance * image.width() * image.height())) {
+            image.save(QDir::current().filePath(name));
+            QFAIL(qPrintable(
+                QStringLiteral("%1 pixels differ from %2, actual image saved "
+                               "to the working directory")
+                    .arg(mismatched)
+                    .arg(goldenDir.filePath(name))));
+        }
+    }
+};
+
+int main(int argc, char *argv[]) {
+    if (!qEnvironmentVariableIsSet("QT_QPA_PLATFORM")) {
+        qputenv("QT_QPA_PLATFORM", "offscreen");
+    }
+    QApplication app(argc, argv);
+    QApplication::setStyle(QStringLiteral("Fusion"));
+    auto test = TitleBarRenderTest();
+    return QTest::qExec(&test, argc, argv);
+}
+
+#include "csdrendertest.moc"
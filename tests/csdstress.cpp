@@ -0,0 +1,273 @@
+#include "csdglyphcache.h"
+#include "csdinstrumentation.h"
+#include "demowindow.h"
+
+#include <QApplication>
+#include <QCommandLineParser>
+#include <QElapsedTimer>
+
+#include <algorithm>
+#include <cstdio>
+#include <vector>
+
+#ifdef __linux__
+#include <fstream>
+
+#include <unistd.h>
+#endif
+
+static long long residentSetKb() {
+#ifdef __linux__
+    std::ifstream statm("/proc/self/statm");
+    long long pages = 0;
+    long long residentPages = 0;
+    if (!(statm >> pages >> residentPages)) {
+        return -1;
+    }
+    return residentPages * (sysconf(_SC_PAGESIZE) / 1024);
+#else
+    return -1;
+#endif
+}
+
+static int liveObjectCount() {
+    int count = 1 + qApp->findChildren<QObject *>().size();
+    for (QWidget *widget : QApplication::topLevelWidgets()) {
+        if (widget->parent() == nullptr) {
+            count += 1 + widget->findChildren<QObject *>().size();
+        }
+    }
+    return count;
+}
+
+// Creates, shows, activates, maximizes and destroys decorated windows in
+// batches and prints one CSV line of memory statistics per batch. Run it on
+// the offscreen platform or under Xvfb; anything that grows from batch to
+// batch is leaking. The event filter dispatch columns are only filled in
+// when the library is built with CSD_INSTRUMENTATION and should stay flat
+// as the number of windows created so far grows.
+static int runStress(DecorationFilter *filter,
+                     CSD::TitleBarMode titleBarMode,
+                     bool themed,
+                     int windowCount,
+                     int batchSize) {
+    std::printf("batch,windows,avgCreateUs,maxCreateUs,rssKb,qobjects,"
+                "glyphCacheKb,decoratedWidgets,filterDispatches,"
+                "avgDispatchNs\n");
+    auto windows = std::vector<DemoWindow *>();
+    windows.reserve(static_cast<std::size_t>(batchSize));
+    int created = 0;
+    for (int batch = 0; created < windowCount; ++batch) {
+        const int count = std::min(batchSize, windowCount - created);
+        const auto countersBefore = CSD::Instrumentation::globalCounters();
+        qint64 totalNs = 0;
+        qint64 maxNs = 0;
+        for (int i = 0; i < count; ++i) {
+            auto timer = QElapsedTimer();
+            timer.start();
+            auto *window = new DemoWindow(titleBarMode, themed);
+            window->resize(640, 480);
+            decorate(filter, window);
+            window->show();
+            const qint64 elapsedNs = timer.nsecsElapsed();
+            totalNs += elapsedNs;
+            maxNs = std::max(maxNs, elapsedNs);
+            windows.push_back(window);
+        }
+        QCoreApplication::processEvents();
+        for (DemoWindow *window : windows) {
+            window->activateWindow();
+            window->setWindowState(window->windowState() |
+                                   Qt::WindowMaximized);
+        }
+        QCoreApplication::processEvents();
+        for (DemoWindow *window : windows) {
+            delete window;
+        }
+        windows.clear();
+        QCoreApplication::sendPostedEvents(nullptr, QEvent::DeferredDelete);
+        QCoreApplication::processEvents();
+        created += count;
+
+        const auto countersAfter = CSD::Instrumentation::globalCounters();
+        const auto counterDelta = [&](CSD::Instrumentation::Counter counter) {
+            return countersAfter[counter] - countersBefore[counter];
+        };
+        const quint64 dispatches =
+            counterDelta(CSD::Instrumentation::FilterDispatches);
+        const quint64 dispatchNs =
+            counterDelta(CSD::Instrumentation::FilterDispatchNs);
+        std::printf("%d,%d,%lld,%lld,%lld,%d,%d,%zu,%llu,%llu\n",
+                    batch,
+                    created,
+                    static_cast<long long>(totalNs / count / 1000),
+                    static_cast<long long>(maxNs / 1000),
+                    residentSetKb(),
+                    liveObjectCount(),
+                    CSD::Internal::GlyphCache::instance().cacheCost(),
+                    filter->decoratedWidgetCount(),
+                    static_cast<unsigned long long>(dispatches),
+                    static_cast<unsigned long long>(
+                        dispatches == 0 ? 0 : dispatchNs / dispatches));
+        std::fflush(stdout);
+    }
+    return 0;
+}
+
+// Repaints the title bar of one decorated window <frames> times and prints
+// the average time per frame. Run it with and without --themed under
+// --style-sheet to see what style sheet rule matching costs.
+static int runPaintBenchmark(DecorationFilter *filter,
+                             CSD::TitleBarMode titleBarMode,
+                             bool themed,
+                             int frames) {
+    auto *window = new DemoWindow(titleBarMode, themed);
+    window->resize(640, 480);
+    decorate(filter, window);
+    window->show();
+    QCoreApplication::processEvents();
+
+    auto *titleBar = window->titleBar();
+    auto timer = QElapsedTimer();
+    timer.start();
+    for (int i = 0; i < frames; ++i) {
+        titleBar->repaint();
+    }
+    const qint64 elapsedNs = timer.nsecsElapsed();
+    std::printf("frames,avgPaintUs\n%d,%.2f\n",
+                frames,
+                static_cast<double>(elapsedNs) / 1000.0 / frames);
+    delete window;
+    return 0;
+}
+
+// Resizes one decorated window back and forth <steps> times, letting every
+// step paint, and prints the resulting frame rate and how many steps the
+// title bar spent in live resize mode. Run it with and without
+// --no-live-resize to compare both paths.
+static int runResizeSweep(DecorationFilter *filter,
+                          CSD::TitleBarMode titleBarMode,
+                          bool themed,
+                          bool liveResize,
+                          int steps) {
+    constexpr int minWidth = 480;
+    constexpr int maxWidth = 1120;
+    constexpr int stepWidth = 8;
+    auto *window = new DemoWindow(titleBarMode, themed);
+    window->resize(minWidth, 480);
+    decorate(filter, window);
+    window->show();
+    QCoreApplication::processEvents();
+
+    auto *titleBar = window->titleBar();
+    titleBar->setLiveResizeEnabled(liveResize);
+    int width = minWidth;
+    int direction = 1;
+    int liveSteps = 0;
+    auto timer = QElapsedTimer();
+    timer.start();
+    for (int i = 0; i < steps; ++i) {
+        if (width + direction * stepWidth > maxWidth ||
+            width + direction * stepWidth < minWidth) {
+            direction = -direction;
+        }
+        width += direction * stepWidth;
+        window->resize(width, 480);
+        QCoreApplication::processEvents();
+        liveSteps += titleBar->isLiveResizing() ? 1 : 0;
+    }
+    const qint64 elapsedNs = timer.nsecsElapsed();
+    std::printf("steps,fps,liveSteps\n%d,%.1f,%d\n",
+                steps,
+                static_cast<double>(steps) * 1e9 /
+                    static_cast<double>(std::max<qint64>(elapsedNs, 1)),
+                liveSteps);
+    delete window;
+    return 0;
+}
+
+int main(int argc, char *argv[]) {
+    QApplication::setAttribute(Qt::AA_EnableHighDpiScaling);
+    QApplication::setAttribute(Qt::AA_UseHighDpiPixmaps);
+    QApplication app(argc, argv);
+    QApplication::setApplicationName("qt-csd-stress");
+
+    auto parser = QCommandLineParser();
+    parser.addHelpOption();
+    const auto stressOption = QCommandLineOption(
+        "stress",
+        "Create and destroy <windows> decorated windows, printing memory "
+        "statistics after every batch.",
+        "windows");
+    const auto batchOption = QCommandLineOption(
+        "batch", "Windows per stress batch.", "size", "100");
+    const auto paintedOption = QCommandLineOption(
+        "painted",
+        "Draw the caption icon and buttons in the title bar instead of "
+        "creating widgets for them.");
+    const auto themedOption = QCommandLineOption(
+        "themed",
+        "Paint the title bar from a TitleBarTheme instead of the widget "
+        "style.");
+    const auto styleSheetOption = QCommandLineOption(
+        "style-sheet", "Set <sheet> as the application style sheet.", "sheet");
+    const auto paintBenchOption = QCommandLineOption(
+        "paint-bench",
+        "Repaint the title bar <frames> times and print the average paint "
+        "time.",
+        "frames");
+    const auto resizeSweepOption = QCommandLineOption(
+        "resize-sweep",
+        "Resize a window back and forth <steps> times and print the frame "
+        "rate.",
+        "steps");
+    const auto noLiveResizeOption = QCommandLineOption(
+        "no-live-resize",
+        "Lay out the title bar on every --resize-sweep step instead of "
+        "drawing the caption buttons from a snapshot.");
+    parser.addOption(stressOption);
+    parser.addOption(batchOption);
+    parser.addOption(paintedOption);
+    parser.addOption(themedOption);
+    parser.addOption(styleSheetOption);
+    parser.addOption(paintBenchOption);
+    parser.addOption(resizeSweepOption);
+    parser.addOption(noLiveResizeOption);
+    parser.process(app);
+    const auto titleBarMode = parser.isSet(paintedOption)
+                                  ? CSD::TitleBarMode::Painted
+                                  : CSD::TitleBarMode::Widgets;
+    const bool themed = parser.isSet(themedOption);
+    if (parser.isSet(styleSheetOption)) {
+        app.setStyleSheet(parser.value(styleSheetOption));
+    }
+
+    auto filter = DecorationFilter();
+#ifdef _WIN32
+    app.installNativeEventFilter(&filter);
+#endif
+
+    if (parser.isSet(stressOption)) {
+        return runStress(&filter,
+                         titleBarMode,
+                         themed,
+                         parser.value(stressOption).toInt(),
+                         std::max(1, parser.value(batchOption).toInt()));
+    }
+    if (parser.isSet(paintBenchOption)) {
+        return runPaintBenchmark(
+            &filter,
+            titleBarMode,
+            themed,
+            std::max(1, parser.value(paintBenchOption).toInt()));
+    }
+    if (parser.isSet(resizeSweepOption)) {
+        return runResizeSweep(
+            &filter,
+            titleBarMode,
+            themed,
+            !parser.isSet(noLiveResizeOption),
+            std::max(1, parser.value(resizeSweepOption).toInt()));
+    }
+    parser.showHelp(1);
+}
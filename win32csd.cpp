@@ -5,13 +5,54 @@
 #include <QWidget>
 #include <QWindow>
 
+#include <private/qhighdpiscaling_p.h>
 #include <qpa/qplatformnativeinterface.h>
 
+#include <array>
+
 namespace CSD::Internal {
 
+// Indexed by HitRegion
+constexpr static std::array<LRESULT, 9> hitTestResults = {
+    0,
+    HTLEFT,
+    HTRIGHT,
+    HTTOP,
+    HTBOTTOM,
+    HTTOPLEFT,
+    HTTOPRIGHT,
+    HTBOTTOMLEFT,
+    HTBOTTOMRIGHT,
+};
+
+// Edges resize only along the axes the widget's size constraints allow, and
+// never while the window is maximized
+static void setHitTesterGeometry(HitTester &hitTester,
+                                 const QWidget *widget,
+                                 const QSize &clientSize,
+                                 bool maximized) {
+    hitTester.setGeometry(
+        clientSize,
+        !maximized && widget->minimumWidth() != widget->maximumWidth(),
+        !maximized && widget->minimumHeight() != widget->maximumHeight());
+}
+
+static void
+updateHitTester(HitTester &hitTester, const QWidget *widget, HWND hwnd) {
+    auto clientRect = ::RECT();
+    if (!::GetClientRect(hwnd, &clientRect)) {
+        return;
+    }
+    setHitTesterGeometry(hitTester,
+                         widget,
+                         QSize(static_cast<int>(clientRect.right),
+                               static_cast<int>(clientRect.bottom)),
+                         ::IsZoomed(hwnd) != FALSE);
+}
+
 Win32ClientSideDecorationFilter::HWNDData::HWNDData(
     QWidget *widget,
-    std::function<bool()> isCaptionHovered,
+    std::function<bool(const QPoint &)> isCaptionHovered,
     std::function<void()> onActivationChanged,
     std::function<void()> onWindowStateChanged)
     : widget(widget), isCaptionHovered(std::move(isCaptionHovered)),
@@ -33,6 +74,9 @@ bool Win32ClientSideDecorationFilter::eventFilter(QObject *watched,
                      [watched](const auto &hwndDataPair) {
                          return hwndDataPair.second.widget == watched;
                      });
+    if (resultIterator == std::end(this->appliedHWNDs)) {
+        return false;
+    }
 
     if (event->type() == QEvent::ActivationChange) {
         resultIterator->second.onActivationChanged();
@@ -40,6 +84,11 @@ bool Win32ClientSideDecorationFilter::eventFilter(QObject *watched,
     } else if (event->type() == QEvent::WindowStateChange) {
         resultIterator->second.onWindowStateChanged();
         return false;
+    } else if (event->type() == QEvent::LayoutRequest ||
+               event->type() == QEvent::Show) {
+        // The minimum and maximum size change without a WM_SIZE
+        updateHitTester(
+            resultIterator->second.hitTester, widget, resultIterator->first);
     }
 
     QWindow *window = widget->windowHandle();
@@ -138,62 +187,23 @@ bool Win32ClientSideDecorationFilter::nativeEventFilter(
     }
 
     if (msg->message == WM_NCHITTEST) {
-        *result = 0;
-        const LONG borderWidth = 8;
-        auto clientRect = ::RECT();
-        ::GetWindowRect(msg->hwnd, &clientRect);
-
-        auto x = GET_X_LPARAM(msg->lParam);
-        auto y = GET_Y_LPARAM(msg->lParam);
-
-        auto resizeWidth = resultIterator->second.widget->minimumWidth() !=
-                           resultIterator->second.widget->maximumWidth();
-        auto resizeHeight = resultIterator->second.widget->minimumHeight() !=
-                            resultIterator->second.widget->maximumHeight();
-
-        if (resizeWidth) {
-            if (x >= clientRect.left && x < clientRect.left + borderWidth) {
-                *result = HTLEFT;
-            }
-            if (x < clientRect.right && x >= clientRect.right - borderWidth) {
-                *result = HTRIGHT;
-            }
-        }
-        if (resizeHeight) {
-            if (y < clientRect.bottom &&
-                y >= clientRect.bottom - borderWidth) {
-                *result = HTBOTTOM;
-            }
-            if (y >= clientRect.top && y < clientRect.top + borderWidth) {
-                *result = HTTOP;
-            }
-        }
-        if (resizeWidth && resizeHeight) {
-            if (x >= clientRect.left && x < clientRect.left + borderWidth &&
-                y < clientRect.bottom &&
-                y >= clientRect.bottom - borderWidth) {
-                *result = HTBOTTOMLEFT;
-            }
-            if (x < clientRect.right && x >= clientRect.right - borderWidth &&
-                y < clientRect.bottom &&
-                y >= clientRect.bottom - borderWidth) {
-                *result = HTBOTTOMRIGHT;
-            }
-            if (x >= clientRect.left && x < clientRect.left + borderWidth &&
-                y >= clientRect.top && y < clientRect.top + borderWidth) {
-                *result = HTTOPLEFT;
-            }
-            if (x < clientRect.right && x >= clientRect.right - borderWidth &&
-                y >= clientRect.top && y < clientRect.top + borderWidth) {
-                *result = HTTOPRIGHT;
-            }
-        }
+        // The client area covers the whole window, see WM_NCCALCSIZE
+        auto point = ::POINT{GET_X_LPARAM(msg->lParam),
+                             GET_Y_LPARAM(msg->lParam)};
+        ::ScreenToClient(msg->hwnd, &point);
+        const auto region = resultIterator->second.hitTester.classify(
+            QPoint(static_cast<int>(point.x), static_cast<int>(point.y)));
+        *result = hitTestResults[static_cast<std::size_t>(region)];
 
         if (*result != 0) {
             return true;
         }
 
-        if (resultIterator->second.isCaptionHovered()) {
+        QWindow *window = resultIterator->second.widget->windowHandle();
+        const auto globalPos = QHighDpi::fromNativePixels(
+            QPoint(GET_X_LPARAM(msg->lParam), GET_Y_LPARAM(msg->lParam)),
+            window);
+        if (resultIterator->second.isCaptionHovered(globalPos)) {
             *result = HTCAPTION;
             return true;
         }
@@ -209,6 +219,11 @@ bool Win32ClientSideDecorationFilter::nativeEventFilter(
     }
 
     if (msg->message == WM_SIZE) {
+        setHitTesterGeometry(resultIterator->second.hitTester,
+                             resultIterator->second.widget,
+                             QSize(static_cast<int>(LOWORD(msg->lParam)),
+                                   static_cast<int>(HIWORD(msg->lParam))),
+                             msg->wParam == SIZE_MAXIMIZED);
     }
 
     if (msg->message == WM_GETMINMAXINFO) {
@@ -219,15 +234,25 @@ bool Win32ClientSideDecorationFilter::nativeEventFilter(
 
 void Win32ClientSideDecorationFilter::apply(
     QWidget *widget,
-    std::function<bool()> isCaptionHovered,
+    std::function<bool(const QPoint &)> isCaptionHovered,
     std::function<void()> onActivationChanged,
     std::function<void()> onWindowStateChanged) {
-    this->appliedHWNDs.emplace(reinterpret_cast<HWND>(widget->winId()),
-                               HWNDData(widget,
-                                        std::move(isCaptionHovered),
-                                        std::move(onActivationChanged),
-                                        std::move(onWindowStateChanged)));
+    // winId() creates the native window, so its first WM_SIZE arrives before
+    // the entry exists and the hit tester has to be seeded here
+    const auto hwnd = reinterpret_cast<HWND>(widget->winId());
+    auto &data = this->appliedHWNDs
+                     .emplace(hwnd,
+                              HWNDData(widget,
+                                       std::move(isCaptionHovered),
+                                       std::move(onActivationChanged),
+                                       std::move(onWindowStateChanged)))
+                     .first->second;
+    updateHitTester(data.hitTester, widget, hwnd);
     widget->installEventFilter(this);
 }
 
+std::size_t Win32ClientSideDecorationFilter::decoratedWidgetCount() const {
+    return this->appliedHWNDs.size();
+}
+
 } // namespace CSD::Internal
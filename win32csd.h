@@ -1,5 +1,7 @@
 #pragma once
 
+#include "csdhittest.h"
+
 #include <Windows.h>
 #include <dwmapi.h>
 #include <windowsx.h>
@@ -8,6 +10,7 @@
 #include <QMargins>
 #include <QMetaType>
 #include <QObject>
+#include <QPoint>
 
 #include <functional>
 #include <unordered_map>
@@ -25,11 +28,12 @@ class Win32ClientSideDecorationFilter : public QObject,
 private:
     struct HWNDData {
         QWidget *widget;
-        std::function<bool()> isCaptionHovered;
+        std::function<bool(const QPoint &)> isCaptionHovered;
         std::function<void()> onActivationChanged;
         std::function<void()> onWindowStateChanged;
+        HitTester hitTester;
         HWNDData(QWidget *widget,
-                 std::function<bool()> isCaptionHovered,
+                 std::function<bool(const QPoint &)> isCaptionHovered,
                  std::function<void()> onActivationChanged,
                  std::function<void()> onWindowStateChanged);
     };
@@ -44,8 +48,9 @@ public:
                            void *message,
                            long *result) override;
     void apply(QWidget *widget,
-               std::function<bool()> isCaptionHovered,
+               std::function<bool(const QPoint &)> isCaptionHovered,
                std::function<void()> onActivationChanged,
                std::function<void()> onWindowStateChanged);
+    std::size_t decoratedWidgetCount() const;
 };
 } // namespace CSD::Internal